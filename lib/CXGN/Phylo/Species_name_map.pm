@@ -270,5 +270,23 @@ sub get_map_string{
 	return $string;
 }
 
+=head2 function write_map_file
+
+Synopsis: 	$snm->write_map_file($filename)
+	Arguments:	a file name
+	Returns:	nothing
+	Description:	 Writes get_map_string to the file, e.g. for urec -m, which then standardizes 
+	the species of the leaves itself.
+
+=cut
+
+sub write_map_file{
+	my $self = shift;
+	my $filename = shift;
+	open my $fh, ">", $filename or die "Couldn't open $filename for writing: $!\n";
+	print $fh $self->get_map_string(), "\n";
+	close $fh;
+}
+
 
 1;
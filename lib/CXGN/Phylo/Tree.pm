@@ -39,6 +39,7 @@ use CXGN::Phylo::Species_name_map;
 use CXGN::Phylo::Layout;
 use CXGN::Phylo::Renderer;
 use CXGN::Phylo::Parser;
+use File::Temp qw/ tempfile /;
 
 use base qw | CXGN::DB::Object |;
 
@@ -2334,16 +2335,37 @@ sub get_ortholog_group_candidate_subtrees{
 }
 
 
-sub make_names_urec_ok{
-  my $self = shift;
-  my @nodes = $self->get_all_nodes();
-  foreach my $a_node (@nodes){
-    my $name = $a_node->get_name();
-    if($name =~ /^[a-zA-Z]/){ # ok - leave as is.
-    }else{ # add X_ in front to make urec happy
-      $a_node->set_name("X_$name");
-    }
-  }
+# the urec executable: $ENV{UREC}, the build in Urec/ next to this module,
+# or urec from the PATH, the first one that knows -F tsv (find_mindl_nodes);
+# older builds, like the one checked in, do not
+my $urec_command;
+sub urec_command{
+	return $urec_command if(defined $urec_command);
+	(my $dir = __FILE__) =~ s{[^/]*$}{};
+	my @candidates = grep { defined $_ } ($ENV{UREC}, "${dir}Urec/urec", 'urec');
+	foreach my $urec (@candidates) {
+		# without arguments urec prints its usage
+		my $usage = `$urec 2>/dev/null`;
+		return $urec_command = $urec if(defined $usage and $usage =~ /-F tsv/);
+	}
+	die "urec_command: no urec with -F tsv among ", join(", ", @candidates),
+	  "; run make in ${dir}Urec or set UREC.\n";
+}
+
+# the newick string of a rooted gene tree, with species attributes, for
+# urec; polytomies are left to urec, which resolves them for the species tree
+sub urec_gene_newick{
+	my $gene_tree = shift;
+	$gene_tree->show_newick_attribute("species");
+	$gene_tree->set_show_standard_species(1);
+	return $gene_tree->generate_newick();
+}
+
+sub urec_species_newick{
+	my $species_t = shift;
+	$species_t->show_newick_attribute("species");
+	$species_t->set_show_standard_species(1);
+	return $species_t->generate_newick();
 }
 
 	# using urec, find the node s.t. rooting on its branch gives minimal duplications and losses
@@ -2351,93 +2373,60 @@ sub make_names_urec_ok{
 sub find_mindl_node{
 	my $gene_tree = shift;				# a rooted gene tree
 	my $species_t = shift;				# a species tree
-#print "in find_mindl_node. species_tree newick: \n", $species_t->subtree_newick(), " \n";
-	
-# print STDERR "##################### Top of find_mindl_node. #############\n";
-	# urec requires binary tree - make sure the tree is binary
-	# if polytomy at root, reroot a bit down one branch, to get binary root (if was tritomy)
-	my @new_root_point;
-	{
-		my @root_children = $gene_tree->get_root()->get_children();
-		if (scalar @root_children != 2) {
-			@new_root_point = ($root_children[0], 0.9*$root_children[0]->get_branch_length());
-			$gene_tree->reset_root_to_point_on_branch(@new_root_point);
-		}
-	}
-	# binarify every non-binary node. At present doesn't attempt to choose in a smart way
-	# among the various possible resolutions
-	$gene_tree->make_binary($gene_tree->get_root()); # urec requires binary tree. 
+	my $points = find_mindl_nodes([$gene_tree], $species_t);
+	return @{$points->[0]};
+}
 
-	my $store_show_std_species = $gene_tree->get_show_standard_species();
-	# put the trees into form of newick strings with no whitespace, so urec will be happy
-	$gene_tree->show_newick_attribute("species");
-	$gene_tree->set_show_standard_species(1);
- # make sure node names start with alphabetic char to make urec happy.
-	$gene_tree->make_names_urec_ok();
-	# need to redo node implicit names here.
-	my $gene_newick_string = $gene_tree->generate_newick();
-#	print "binarified gene tree (urec input): ", $gene_newick_string, "\n";
-	$gene_newick_string =~ s/\s//g; 
+	# find_mindl_node for many gene trees with one urec run. Returns a ref to an
+	# array holding, for the gene tree with the same index, the point to reroot
+	# at as [node, distance along its branch], or [undef, undef] for a tree
+	# with a single leaf. If the optimal edge is one urec made inside a
+	# polytomy, the point is the polytomy node itself (distance 0).
+sub find_mindl_nodes{
+	my $gene_trees = shift;				# ref to array of rooted gene trees
+	my $species_t = shift;				# a species tree
+	my @points = ();
+	return \@points unless(@$gene_trees);
 
-	$species_t->show_newick_attribute("species");
-	$species_t->set_show_standard_species(1);
-my @thenodes = $species_t->get_leaves();
-	foreach my $a_node (@thenodes){
-#	  print "species,stdspecies: ", $a_node->get_species(), "  ", $a_node->get_standard_species(), "\n";
+	my $species_newick_string = urec_species_newick($species_t);
+	my ($fh, $gene_filename) = tempfile(UNLINK => 1);
+	foreach my $gene_tree (@$gene_trees) {
+		print $fh urec_gene_newick($gene_tree), "\n";
 	}
-#print "species tree (from subtree_newick): ", $species_t->subtree_newick(), "\n";
-	my $species_newick_string = $species_t->generate_newick();
-	$species_newick_string =~ s/\s//g; # remove whitespace
-#print "species tree newick string: $species_newick_string\n";
-#print "gene newick string: $gene_newick_string \n\n";
-#print "about to call urec. \n";
-# print STDERR "about to call urec, with gene tree newick:\n$gene_newick_string \n$species_newick_string \n";
-#	my $rerooted_newick = `/home/tomfy/cxgn/cxgn-corelibs/lib/CXGN/Phylo/Urec/urec -s "$species_newick_string"  -g "$gene_newick_string" -b -O`;
-#	my $rerooted_newick = `/data/local/cxgn/core/perllib/CXGN/Phylo/Urec/urec -s "$species_newick_string"  -g "$gene_newick_string" -b -O`;
-
-	my $rerooted_newick; 
-#	my $urec_dir = `which urec`;
-#	if($urec_dir =~ /\S/){
-	if(`which urec` =~ /\S/){
- 		$rerooted_newick = `urec -s "$species_newick_string"  -g "$gene_newick_string" -b -O`;
-}else{
-	$rerooted_newick = `/data/local/cxgn-old/core/perllib/CXGN/Phylo/Urec/urec -s "$species_newick_string"  -g "$gene_newick_string" -b -O`;	
-}
-
-	#	print STDERR "gene_newick_string: \n $gene_newick_string   \n\nspecies_newick_string: \n $species_newick_string.\n\n";
-#		print STDERR "Rerooted newick string: [$rerooted_newick].\n";
-
-# print "parsing mindl rerooted gene tree in Tree\n";
-	my $minDL_rerooted_gene_tree = (CXGN::Phylo::Parse_newick->new($rerooted_newick, $do_parse_set_error))->parse(); # this is now rooted so as to minimize gene duplication and loss needed to reconcile with species tree,
-	# but  branch lengthswill be wrong for nodes whose parent has changed in the rerooting (they are just the branch lengths to the old parents). 
-	$minDL_rerooted_gene_tree->get_root()->recursive_implicit_names();
-
-	# $minDL_rerooted_gene_tree should have 2 children and (at least) one should have it's subtree also present in the pre-rerooting tree.
-	# identify the node at the root of this subtree (using implicit names) and reroot there.
-	# Have to do this because some branch length info was lost in urec step. 
-#	warn "minDL_rerooted_gene_tree newick: \n", $minDL_rerooted_gene_tree->generate_newick(), "\n";
-	my @root_children = $minDL_rerooted_gene_tree->get_root()->get_children();
-	my ($node_key, $rr_node);
-	foreach (@root_children) {
-		my $implicit_name_string = join("\t", @{$_->get_implicit_names()});
-	#	warn "implicit name string: $implicit_name_string \n";
-		($node_key, $rr_node) = $gene_tree->node_from_implicit_name_string($implicit_name_string);
-		if (defined $rr_node) {
-		  $minDL_rerooted_gene_tree->decircularize();
-		#	debug ("Reroot above this node: $implicit_name_string \n"); 
-#		  warn "branch length along which to reroot: ", $rr_node->get_branch_length(), "\n";
-			return @new_root_point = ($rr_node, 0.5*($rr_node->get_branch_length()));
+	close $fh;
+
+	# one line per gene tree: species tree, gene tree, weights, then the ends
+	# of the optimal edge as preorder indices in the newick we wrote (the
+	# second one is the node below the edge) and its dup, loss
+	my $urec = urec_command();
+	open my $out, '-|', $urec, '-s', $species_newick_string, '-G', $gene_filename, '-F', 'tsv'
+	  or die "find_mindl_nodes: cannot run $urec: $!\n";
+	my @lines = <$out>;
+	close $out or die "find_mindl_nodes: $urec failed", ($! ? ": $!" : " with status " . ($? >> 8)), "\n";
+	die "find_mindl_nodes: urec gave ", scalar @lines, " results for ", scalar @$gene_trees, " gene trees.\n" 
+	  unless(scalar @lines == scalar @$gene_trees);
+
+	for my $line (@lines) {
+		my ($i, $up, $edge) = (split("\t", $line))[1, 3, 4];
+		die "find_mindl_nodes: unexpected urec output: $line" unless(defined $edge and $edge =~ /^\d+$/);
+		# preorder in the order generate_newick writes the children
+		my @preorder = ();
+		my @stack = ($gene_trees->[$i]->get_root());
+		while (@stack) {
+			my $node = pop @stack;
+			push @preorder, $node;
+			push @stack, reverse $node->get_children() unless($node->is_leaf());
+		}
+		my $rr_node = $preorder[$edge];
+		if ($edge == 0 or !defined $rr_node) {
+			push @points, [undef, undef];
+		} elsif ($up == $edge) {
+			push @points, [$rr_node, 0];
+		} else {
+			push @points, [$rr_node, 0.5*($rr_node->get_branch_length())];
 		}
 	}
-$| = 1;
-
-	warn "problem with mindl rerooting. minDL_rerooted_gene_tree newick: \n", 
-	  $minDL_rerooted_gene_tree->generate_newick(), "\n";
-	die "find_mindl_node failed. \n";
-
-#	$gene_tree->set_shown_standard_species($store_show_standard_species);
-#$gene_tree->update_label_names();
-	return (undef, undef);
+	return \@points;
 }
 
 sub get_species_bithash{ #get a hash giving a bit pattern for each species in both $gene_tree and $spec_tree
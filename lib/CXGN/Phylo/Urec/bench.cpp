@@ -0,0 +1,176 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+// Throughput benchmarks for urec; see "make bench".
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "loader.h"
+#include "parallel.h"
+#include "bintree.h"
+#include "zstream.h"
+
+double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv,NULL);
+    return tv.tv_sec+tv.tv_usec/1e6;
+}
+
+void report(const char *name, size_t bytes, size_t trees, double t)
+{
+    printf("%-8s %8lu trees %10.2f MB %8.3f s %10.2f MB/s\n",name,
+	   (unsigned long)trees,bytes/1e6,t,bytes/1e6/t);
+}
+
+void benchload(char *fn, int reps)
+{
+    struct stat st;
+    if (stat(fn,&st)<0)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    for (int r=0; r<reps; r++)
+    {
+	utreevec a,b;
+	double t0=now();
+	readgtree_fgets(fn,a);
+	double t1=now();
+	if (!readgtree_mmap(fn,b))
+	{
+	    cerr << "Cannot map file " << fn << endl;
+	    exit(-1);
+	}
+	double t2=now();
+	if (a.size()!=b.size())
+	    cerr << "Tree count differs: fgets " << a.size() << " mmap " << b.size() << endl;
+	report("fgets",st.st_size,a.size(),t1-t0);
+	report("mmap",st.st_size,b.size(),t2-t1);
+	for (size_t i=0; i<a.size(); i++) delete a[i];
+	for (size_t i=0; i<b.size(); i++) delete b[i];
+    }
+}
+
+void benchbin(char *fn, int reps)
+{
+    struct stat st;
+    FILE *f = stat(fn,&st)<0 ? NULL : zopen(fn,"r");
+    if (!f || !isbinary(f))
+    {
+	cerr << "Cannot open binary tree file " << fn << endl;
+	exit(-1);
+    }
+    fclose(f);
+    for (int r=0; r<reps; r++)
+    {
+	utreevec a;
+	double t0=now();
+	readgtree_bin(zopen(fn,"r"),fn,a);
+	report("binary",st.st_size,a.size(),now()-t0);
+	for (size_t i=0; i<a.size(); i++) delete a[i];
+    }
+}
+
+// the -v/-b cost matrix: plain nested loops against tiles
+void benchmatrix(char *gfn, char *sfn, int reps)
+{
+    utreevec g;
+    readgtree(gfn,g);
+    vector<SpeciesTree*> s;
+    FILE *f=fopen(sfn,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << sfn << endl;
+	exit(-1);
+    }
+    char *buf=NULL;
+    size_t len=0;
+    while (getline(&buf,&len,f)>=0)
+	if (strspn(buf," \t\r\n")<strlen(buf)) s.push_back(new SpeciesTree(buf));
+    free(buf);
+    fclose(f);
+    size_t pairs=g.size()*s.size();
+    printf("%lu gene trees x %lu species trees, %d threads, L2 %ld KB\n",(unsigned long)g.size(),
+	   (unsigned long)s.size(),threadcount(),cachesize()>>10);
+    for (int r=0; r<reps; r++)
+    {
+	PairCosts a(g,s,NULL,0), b(g,s,NULL,0);
+	double t0=now();
+	a.runnested();
+	double t1=now();
+	b.run();
+	double t2=now();
+	for (size_t i=0; i<g.size(); i++)
+	    for (size_t j=0; j<s.size(); j++)
+		if (a.at(i,j).cost.dup!=b.at(i,j).cost.dup || a.at(i,j).cost.loss!=b.at(i,j).cost.loss)
+		{
+		    cerr << "Costs differ: gene tree " << i << " species tree " << j << endl;
+		    exit(-1);
+		}
+	printf("%-8s %10lu pairs %8.3f s %10.0f pairs/s\n","nested",(unsigned long)pairs,t1-t0,pairs/(t1-t0));
+	printf("%-8s %10lu pairs %8.3f s %10.0f pairs/s\n","tiled",(unsigned long)pairs,t2-t1,pairs/(t2-t1));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int reps=3;
+    char *gfile=NULL, *bfile=NULL, *sfile=NULL;
+    while ((opt = getopt (argc, argv, "G:B:S:j:r:")) != -1)
+	switch (opt)
+	{
+	    case 'G':
+		gfile=optarg;
+		break;
+	    case 'B':
+		bfile=optarg;
+		break;
+	    case 'S':
+		sfile=optarg;
+		break;
+	    case 'j':
+		if (sscanf(optarg,"%d",&num_threads)!=1)
+		{
+		    cerr << "Number expected in -j" << endl;
+		    exit(-1);
+		}
+		break;
+	    case 'r':
+		if (sscanf(optarg,"%d",&reps)!=1)
+		{
+		    cerr << "Number expected in -r" << endl;
+		    exit(-1);
+		}
+		break;
+	    default:
+		cerr << "Usage: " << argv[0] << " -G genetrees [-B binarygenetrees] [-S speciestrees] [-j threads] [-r repetitions]" << endl;
+		exit(-1);
+	}
+    if (gfile && sfile)
+    {
+	benchmatrix(gfile,sfile,reps);
+	return 0;
+    }
+    if (gfile)
+    {
+	printf("gene tree loading, %d threads\n",threadcount());
+	benchload(gfile,reps);
+    }
+    if (bfile)
+    {
+	printf("binary gene tree loading, %d threads\n",threadcount());
+	benchbin(bfile,reps);
+    }
+    return 0;
+}
@@ -0,0 +1,350 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+using namespace std;
+
+#include "bintree.h"
+#include "parallel.h"
+#include "zstream.h"
+
+void putvarint(string &o, unsigned long v)
+{
+    while (v>=0x80)
+    {
+	o+=(char)(v|0x80);
+	v>>=7;
+    }
+    o+=(char)v;
+}
+
+static unsigned long getvarint(const unsigned char *&p)
+{
+    unsigned long v=0;
+    int sh=0;
+    while (*p & 0x80) { v|=(unsigned long)(*p++ & 0x7f)<<sh; sh+=7; }
+    return v|((unsigned long)*p++<<sh);
+}
+
+// as getvarint, 0 if it does not end before end or does not fit
+static int getvarint(const unsigned char *&p, const unsigned char *end, unsigned long &v)
+{
+    v=0;
+    for (int sh=0; p<end && sh<64; sh+=7)
+    {
+	v|=(unsigned long)(*p & 0x7f)<<sh;
+	if (!(*p++ & 0x80)) return 1;
+    }
+    return 0;
+}
+
+// Newick text -> topology bits and preorder labels of one tree
+struct TreeEncoder
+{
+    string bits;
+    int nbits;
+    vector<int> labs;
+    unordered_map<string,int> &table;
+    vector<string> &labels;
+
+    TreeEncoder(unordered_map<string,int> &t, vector<string> &l) : nbits(0), table(t), labels(l) {}
+    void bit(int b)
+    {
+	if (!(nbits&7)) bits+='\0';
+	if (b) bits[nbits>>3]|=1<<(nbits&7);
+	nbits++;
+    }
+    int label(char *s, int len)
+    {
+	string l(s,len);
+	unordered_map<string,int>::iterator i = table.find(l);
+	if (i!=table.end()) return i->second+1;
+	table[l]=labels.size();
+	labels.push_back(l);
+	return labels.size();
+    }
+    void node(char *s, int &p)
+    {
+	int pre = labs.size();
+	labs.push_back(0);
+	bit(1);
+	char *cur = nodeTok(s,p);
+	if (cur[0]=='(')
+	{
+	    int nkids=0;
+	    do node(s,p), nkids++;
+	    while (closeTok(s,p,nkids)[0]==',');
+	    if (islabel(s,p))
+	    {
+		char *l = getTok(s,p);
+		labs[pre]=label(l,s+p-l);
+	    }
+	}
+	else labs[pre]=label(cur,s+p-cur);
+	bit(0);
+    }
+    void write(string &o)
+    {
+	putvarint(o,labs.size());
+	o+=bits;
+	for (size_t i=0; i<labs.size(); i++) putvarint(o,labs[i]);
+    }
+};
+
+// converts a file of Newick trees, one per line; returns the number of trees
+int newick2bin(char *in, char *out)
+{
+    FILE *f = zopen(in,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << in << endl;
+	exit(-1);
+    }
+    unordered_map<string,int> table;
+    vector<string> labels;
+    string trees;
+    int ntrees=0;
+    char *buf=NULL;
+    size_t len=0;
+    while (getline(&buf,&len,f)>=0)
+    {
+	if (strspn(buf," \t\r\n")==strlen(buf)) continue;
+	TreeEncoder e(table,labels);
+	int p=0;
+	e.node(buf,p);
+	endTree(buf,p);
+	e.write(trees);
+	ntrees++;
+    }
+    free(buf);
+    fclose(f);
+
+    string o(BIN_MAGIC,BIN_MAGICLEN);
+    putvarint(o,labels.size());
+    for (size_t i=0; i<labels.size(); i++)
+    {
+	putvarint(o,labels[i].size());
+	o+=labels[i];
+    }
+    putvarint(o,ntrees);
+    FILE *g = zopen(out,"w");
+    if (!g)
+    {
+	cerr << "Cannot open file " << out << endl;
+	exit(-1);
+    }
+    if ((fwrite(o.data(),1,o.size(),g)!=o.size()) || (fwrite(trees.data(),1,trees.size(),g)!=trees.size()) || fclose(g))
+    {
+	cerr << "Cannot write file " << out << endl;
+	exit(-1);
+    }
+    return ntrees;
+}
+
+int isbinary(FILE *f)
+{
+    char m[BIN_MAGICLEN];
+    return zpeek(f,m,BIN_MAGICLEN)==BIN_MAGICLEN && !memcmp(m,BIN_MAGIC,BIN_MAGICLEN);
+}
+
+TreeCode::TreeCode(const unsigned char *p, vector<BinLabel> &t) : table(t)
+{
+    n=getvarint(p);
+    bits=p;
+    labs=p+(2*n+7)/8;
+    pos=0;
+}
+
+int TreeCode::node(BinLabel *&l)
+{
+    pos++; // 1
+    unsigned long id = getvarint(labs);
+    l = id ? &table[id-1] : NULL;
+    return (bits[pos>>3]>>(pos&7))&1;
+}
+
+int TreeCode::more()
+{
+    if ((bits[pos>>3]>>(pos&7))&1) return 1;
+    pos++; // 0
+    return 0;
+}
+
+// A loaded file: the label table split once, and where every tree starts.
+// Every count, length and label is checked against the data, and every
+// tree is a walk with labelled leaves and no node with one child, so
+// TreeCode need not check anything.
+struct BinFile
+{
+    vector<unsigned char> data;
+    vector<BinLabel> labels;
+    vector<const unsigned char*> trees;
+    char *fn;
+
+    void bad()
+    {
+	cerr << fn << ": bad binary tree file" << endl;
+	exit(-1);
+    }
+
+    // the tree at p, which is moved past it
+    void checktree(const unsigned char *&p, const unsigned char *end)
+    {
+	unsigned long n, l;
+	if (!getvarint(p,end,n) || !n || n>(unsigned long)(end-p)*4) bad();
+	const unsigned char *bits=p;
+	p+=(2*n+7)/8;
+	vector<unsigned long> path; // the nodes entered and not left
+	vector<int> kids; // their children so far
+	vector<char> leaf(n);
+	unsigned long pre=0;
+	for (unsigned long i=0; i<2*n; i++)
+	    if ((bits[i>>3]>>(i&7))&1)
+	    {
+		if ((i && path.empty()) || pre==n) bad();
+		if (kids.size()) kids.back()++;
+		path.push_back(pre++);
+		kids.push_back(0);
+	    }
+	    else
+	    {
+		if (path.empty() || kids.back()==1) bad();
+		leaf[path.back()]=!kids.back();
+		path.pop_back();
+		kids.pop_back();
+	    }
+	if (path.size()) bad();
+	for (unsigned long i=0; i<n; i++)
+	    if (!getvarint(p,end,l) || l>labels.size() || (leaf[i] && !l)) bad();
+    }
+
+    BinFile(FILE *f, char *fn_) : fn(fn_)
+    {
+	size_t size=0, r;
+	do
+	{
+	    data.resize(size+(1<<20));
+	    size+=r=fread(&data[size],1,data.size()-size,f);
+	} while (r);
+	if (ferror(f))
+	{
+	    cerr << "Cannot read file " << fn << endl;
+	    exit(-1);
+	}
+	fclose(f);
+	data.resize(size+1); // &data[size] is the end
+	const unsigned char *p=&data[0], *end=p+size;
+	unsigned long n, len;
+	if (size<BIN_MAGICLEN || memcmp(p,BIN_MAGIC,BIN_MAGICLEN)) bad();
+	p+=BIN_MAGICLEN;
+	if (!getvarint(p,end,n) || n>(unsigned long)(end-p)) bad();
+	labels.resize(n);
+	for (size_t i=0; i<labels.size(); i++)
+	{
+	    if (!getvarint(p,end,len) || len>(unsigned long)(end-p)) bad();
+	    BinLabel &l = labels[i];
+	    l.complete.assign((const char*)p,len);
+	    p+=len;
+	    char *name, *species;
+	    leaflabel(l.complete.c_str(),name,species);
+	    l.name=name;
+	    l.species=species;
+	    free(name);
+	    free(species);
+	}
+	if (!getvarint(p,end,n) || n>(unsigned long)(end-p)) bad();
+	trees.resize(n);
+	for (size_t i=0; i<trees.size(); i++)
+	{
+	    trees[i]=p;
+	    checktree(p,end);
+	}
+	if (p!=end) bad();
+    }
+};
+
+struct BinDecoder
+{
+    BinFile &f;
+    utreevec &gt;
+    BinDecoder(BinFile &f_, utreevec &g) : f(f_), gt(g) {}
+    void operator()(int i, int tid)
+    {
+	TreeCode c(f.trees[i],f.labels);
+	gt[i]=new UTree(c);
+    }
+};
+
+void readgtree_bin(FILE *in, char *fn, utreevec &gtset)
+{
+    BinFile f(in,fn);
+    utreevec v(f.trees.size());
+    BinDecoder d(f,v);
+    parallel_for(v.size(),d);
+    gtset.insert(gtset.end(),v.begin(),v.end());
+}
+
+void readstree_bin(FILE *in, char *fn, vector<SpeciesTree*> &stv)
+{
+    BinFile f(in,fn);
+    for (size_t i=0; i<f.trees.size(); i++)
+    {
+	TreeCode c(f.trees[i],f.labels);
+	stv.push_back(new SpeciesTree(c));
+    }
+}
+
+// mirrors UTree::parseNode
+UNode *UTree::decodeNode(TreeCode &c, int fromroot)
+{
+    int pre = parsed++;
+    BinLabel *l;
+    if (!c.node(l))
+    {
+	c.more();
+	start=new ULeaf(l->complete.c_str(),l->name.c_str(),l->species.c_str());
+	start->eid(pre);
+	return start;
+    }
+    nodset kids;
+    while (c.more()) kids.push_back(decodeNode(c,0));
+    if (!fromroot && l) return internal(kids,pre,0,(char*)l->complete.c_str(),l->complete.size());
+    return internal(kids,pre,fromroot);
+}
+
+// mirrors RTree::parseNode
+RNode *RTree::decodeNode(TreeCode &c)
+{
+    BinLabel *l;
+    if (!c.node(l))
+    {
+	c.more();
+	return new RLeaf(l->complete.c_str(),l->name.c_str(),l->species.c_str());
+    }
+    c.more();
+    RNode *a=decodeNode(c);
+    c.more();
+    RNode *b=decodeNode(c);
+    if (c.more())
+    {
+	cerr << "Species trees must be binary" << endl;
+	exit(-1);
+    }
+    if (l) return createInt(a,b,(char*)l->complete.c_str(),l->complete.size());
+    return createInt(a,b);
+}
+
+RTree::RTree(TreeCode &c)
+{
+    rootn=decodeNode(c);
+    rootn->depth(0);
+    number();
+}
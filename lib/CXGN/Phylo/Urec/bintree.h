@@ -0,0 +1,63 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _BINTREE__
+#define _BINTREE__
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "rtree.h"
+#include "urtree.h"
+
+// Binary tree files (-T, read by -G and -S).
+//
+//   "UREC" 1                          magic and version
+//   varint L, L x (varint len, len bytes)   distinct labels as written
+//   varint T, T x tree
+//   tree: varint n (nodes), 2n topology bits, n x varint label
+//
+// Topology bits are the preorder walk, 1 on entering and 0 on leaving a
+// node (so a leaf is 10), packed from the low bit of each byte. The label
+// of every node follows in preorder: 0 for none, else its index+1 in the
+// table. Varints are 7 bits per byte, low bits first.
+
+#define BIN_MAGIC "UREC\1"
+#define BIN_MAGICLEN 5
+
+typedef struct BinLabel
+{
+    string complete, name, species; // see leaflabel()
+} BinLabel;
+
+// the tree at p of a loaded file, decoded by UTree/RTree::decodeNode
+class TreeCode
+{
+    const unsigned char *bits, *labs;
+    int n, pos;
+    vector<BinLabel> &table;
+ public:
+    TreeCode(const unsigned char *p, vector<BinLabel> &t);
+    // enters a node: returns its label (NULL if none) and whether it has children
+    int node(BinLabel *&l);
+    // 1 if another child follows, else leaves the node
+    int more();
+    const unsigned char *end() { return labs; }
+};
+
+void putvarint(string &o, unsigned long v);
+// whether f, just opened by zopen(), is a binary tree file; nothing is
+// taken from f
+int isbinary(FILE *f);
+int newick2bin(char *in, char *out);
+// the trees of binary file f (named fn), which is closed
+void readgtree_bin(FILE *f, char *fn, utreevec &gtset);
+void readstree_bin(FILE *f, char *fn, vector<SpeciesTree*> &stv);
+
+#endif
@@ -0,0 +1,54 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include "clades.h"
+#include "urtree.h"
+
+int CladeTable::leaf(const char *s)
+{
+    unordered_map<string,int>::iterator i = species.find(s);
+    if (i!=species.end()) return i->second;
+    int c = ln.size();
+    species[s]=c;
+    ln.push_back(-1);
+    rn.push_back(-1);
+    lab.push_back(s);
+    return c;
+}
+
+int CladeTable::join(int a, int b)
+{
+    if (a>b) { int t=a; a=b; b=t; }
+    long long key = ((long long)a<<32)|b;
+    unordered_map<long long,int>::iterator i = pairs.find(key);
+    if (i!=pairs.end()) return i->second;
+    int c = ln.size();
+    pairs[key]=c;
+    ln.push_back(a);
+    rn.push_back(b);
+    lab.push_back("");
+    return c;
+}
+
+// children have smaller ids, so one pass in id order is bottom-up
+CladeMemo::CladeMemo(CladeTable &t, SpeciesTree *s) : st(s), M(t.size()), sc(t.size())
+{
+    for (int c=0; c<t.size(); c++)
+    {
+	if (t.isleaf(c))
+	{
+	    M[c]=st->getLeaf((char*)t.label(c));
+	    continue;
+	}
+	RNode *m1=M[t.l(c)], *m2=M[t.r(c)];
+	if (!m1 || !m2) { M[c]=NULL; continue; }
+	RNode *m=M[c]=st->lca(m1,m2);
+	sc[c].loss=sc[t.l(c)].loss+sc[t.r(c)].loss+lossprim(m,m1,m2);
+	sc[c].dup=sc[t.l(c)].dup+sc[t.r(c)].dup+dupprim(m,m1,m2);
+    }
+}
@@ -0,0 +1,57 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _CLADES__
+#define _CLADES__
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+#include "rtree.h"
+
+// Hash-consing of rooted gene subtrees (-H).
+// Every directed node of an unrooted gene tree is the root of a rooted
+// subtree. Subtrees with the same shape and the same species at the leaves
+// get the same clade id, in every gene tree interned into the same table.
+// A clade is either a species (leaf) or an unordered pair of clades;
+// children always get smaller ids than their parents.
+
+class CladeTable
+{
+ protected:
+    unordered_map<string,int> species;     // species label -> clade id
+    unordered_map<long long,int> pairs;    // (smaller,larger) clade ids -> clade id
+    vector<int> ln, rn;                    // children, -1 for a species
+    vector<string> lab;                    // species label of a leaf clade
+ public:
+    long long subtrees;                    // number of directed nodes interned
+    CladeTable() : subtrees(0) {}
+    int leaf(const char *s);
+    int join(int a, int b);
+    int size() { return ln.size(); }
+    int isleaf(int c) { return ln[c]<0; }
+    int l(int c) { return ln[c]; }
+    int r(int c) { return rn[c]; }
+    const char *label(int c) { return lab[c].c_str(); }
+};
+
+// The mapping and the subtree cost of every clade of a table with respect
+// to one species tree. Filled once, then only read, so it can be shared by
+// all ReconcileContexts (and threads) working with that species tree.
+class CladeMemo
+{
+ public:
+    SpeciesTree *st;
+    vector<RNode*> M;  // NULL if a species of the clade is missing in st
+    vector<DlCost> sc;
+    CladeMemo(CladeTable &t, SpeciesTree *s);
+};
+
+#endif
@@ -0,0 +1,172 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+using namespace std;
+
+#include "distfile.h"
+#include "bintree.h"
+#include "zstream.h"
+
+// name.tsv, name.tsv.gz or name.tsv.zst
+static int textname(const char *fn)
+{
+    const char *s=strstr(fn,".tsv");
+    return s && (!s[4] || !strcmp(s+4,".gz") || !strcmp(s+4,".zst"));
+}
+
+DistWriter::DistWriter(char *fn, int append)
+{
+    text=textname(fn);
+    if (!(f=zopen(fn,append ? "a" : "w")))
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    if (!append && !text) fwrite(DIST_MAGIC,1,DIST_MAGICLEN,f);
+}
+
+DistWriter::~DistWriter()
+{
+    if (fclose(f))
+    {
+	cerr << "Cannot write distribution file" << endl;
+	exit(-1);
+    }
+}
+
+// a block is built in buf and written at once
+void DistWriter::write(int species, DlCost *dist, int n)
+{
+    buf.clear();
+    int r=0, last=-1;
+    for (int i=0; i<n; i++) 
+	if (dist[i].dup || dist[i].loss) r++;
+    if (!text)
+    {
+	putvarint(buf,species);
+	putvarint(buf,r);
+    }
+    char line[64];
+    for (int i=0; i<n; i++)
+    {
+	if (!dist[i].dup && !dist[i].loss) continue;
+	if (text)
+	{
+	    snprintf(line,sizeof(line),"%d\t%d\t%d\t%d\n",species,i,dist[i].dup,dist[i].loss);
+	    buf+=line;
+	    continue;
+	}
+	putvarint(buf,i-last);
+	putvarint(buf,dist[i].dup);
+	putvarint(buf,dist[i].loss);
+	last=i;
+    }
+    if (fwrite(buf.data(),1,buf.size(),f)!=buf.size())
+    {
+	cerr << "Cannot write distribution file" << endl;
+	exit(-1);
+    }
+}
+
+long DistWriter::sync()
+{
+    return zsync(f);
+}
+
+DistReader::DistReader(char *fn_) : pending(0), fn(fn_)
+{
+    text=textname(fn);
+    if (!(f=zopen(fn,"r")))
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    char m[DIST_MAGICLEN];
+    if (!text && (fread(m,1,DIST_MAGICLEN,f)!=DIST_MAGICLEN || memcmp(m,DIST_MAGIC,DIST_MAGICLEN)))
+    {
+	cerr << "Not a distribution file: " << fn << endl;
+	exit(-1);
+    }
+}
+
+DistReader::~DistReader()
+{
+    fclose(f);
+}
+
+// -1 at the end of the file
+static long fgetvarint(FILE *f)
+{
+    unsigned long v=0;
+    int sh=0, c;
+    while ((c=getc(f))!=EOF)
+    {
+	v|=(unsigned long)(c & 0x7f)<<sh;
+	if (!(c & 0x80)) return v;
+	sh+=7;
+    }
+    return -1;
+}
+
+int DistReader::read(int &species, vector<DistRecord> &recs)
+{
+    recs.clear();
+    if (text)
+    {
+	// a block is a run of lines of the same species tree
+	if (pending)
+	{
+	    species=nextspecies;
+	    recs.push_back(next);
+	    pending=0;
+	}
+	int s;
+	DistRecord d;
+	while (fscanf(f,"%d %d %d %d",&s,&d.node,&d.dl.dup,&d.dl.loss)==4)
+	{
+	    if (recs.size() && s!=species)
+	    {
+		nextspecies=s;
+		next=d;
+		pending=1;
+		return 1;
+	    }
+	    species=s;
+	    recs.push_back(d);
+	}
+	return recs.size()>0;
+    }
+    long s=fgetvarint(f);
+    if (s<0) return 0;
+    long r=fgetvarint(f);
+    int node=-1;
+    for (long i=0; i<r; i++)
+    {
+	DistRecord d;
+	long gap=fgetvarint(f), dup=fgetvarint(f), loss=fgetvarint(f);
+	if (loss<0)
+	{
+	    cerr << "Truncated distribution file " << fn << endl;
+	    exit(-1);
+	}
+	d.node=node+=gap;
+	d.dl=DlCost(dup,loss);
+	recs.push_back(d);
+    }
+    if (r<0)
+    {
+	cerr << "Truncated distribution file " << fn << endl;
+	exit(-1);
+    }
+    species=s;
+    return 1;
+}
@@ -0,0 +1,68 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _DISTFILE__
+#define _DISTFILE__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "rtree.h"
+
+// Distribution files (-Z): the (dup,loss) of -d at every species tree
+// node, only the nonzero ones, one block per species tree.
+//
+//   "URECD" 1                         magic and version
+//   blocks: varint species, varint R, R x (varint gap, varint dup, varint loss)
+//
+// species counts the species trees from 0 in input order; gap is the
+// preorder index of the node minus that of the previous record (minus -1
+// for the first). Varints are those of bintree.h. A name ending in .tsv
+// (before .gz or .zst) gives text instead, one record per line:
+// species node dup loss.
+
+#define DIST_MAGIC "URECD\1"
+#define DIST_MAGICLEN 6
+
+typedef struct DistRecord
+{
+    int node;
+    DlCost dl;
+} DistRecord;
+
+class DistWriter
+{
+    FILE *f;
+    int text;
+    string buf;
+ public:
+    // append continues a file cut at a block boundary (-U)
+    DistWriter(char *fn, int append);
+    ~DistWriter();
+    void write(int species, DlCost *dist, int n);
+    // size of the file after the blocks written so far, see zsync()
+    long sync();
+};
+
+class DistReader
+{
+    FILE *f;
+    int text, pending;
+    DistRecord next;
+    int nextspecies;
+    char *fn;
+ public:
+    DistReader(char *fn_);
+    ~DistReader();
+    // the next block; 0 at the end of the file
+    int read(int &species, vector<DistRecord> &recs);
+};
+
+#endif
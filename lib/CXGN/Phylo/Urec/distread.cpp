@@ -0,0 +1,98 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+// urecdist: prints the distribution files of urec -Z
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <iostream>
+using namespace std;
+
+#include "rtree.h"
+#include "distfile.h"
+#include "zstream.h"
+
+void usage(char **argv)
+{
+    cout << " Usage: " << argv[0] << " [options] distfile" << endl;
+    cout << " Prints the records of a urec -Z file: species node dup loss" << endl;
+    cout << " -S filename - the species trees of the run: print the distributions as -d does" << endl;
+    cout << " -x - with -S, as -x does" << endl;
+    exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+    int opt, tree=0;
+    vector<SpeciesTree*> stv;
+    while ((opt = getopt (argc, argv, "S:x")) != -1)
+	switch (opt)
+	{
+	    case 'S':
+	    {
+		FILE *f = zopen(optarg,"r");
+		if (!f)
+		{
+		    cerr << "Cannot open file " << optarg << endl;
+		    exit(-1);
+		}
+		char *buf=NULL;
+		size_t len=0;
+		while (getline(&buf,&len,f)>=0)
+		    if (strspn(buf," \t\r\n")<strlen(buf)) stv.push_back(new SpeciesTree(buf));
+		free(buf);
+		fclose(f);
+		break;
+	    }
+	    case 'x':
+		tree=1;
+		break;
+	    default:
+		usage(argv);
+	}
+    if (optind!=argc-1) usage(argv);
+
+    DistReader r(argv[optind]);
+    int s;
+    vector<DistRecord> recs;
+    vector<DlCost> dist;
+    while (r.read(s,recs))
+    {
+	if (!stv.size())
+	{
+	    for (size_t i=0; i<recs.size(); i++)
+		cout << s << "\t" << recs[i].node << "\t" << recs[i].dl.dup << "\t" << recs[i].dl.loss << "\n";
+	    continue;
+	}
+	if (s<0 || s>=(int)stv.size())
+	{
+	    cerr << "Species tree " << s << " is not in -S" << endl;
+	    exit(-1);
+	}
+	SpeciesTree *st=stv[s];
+	dist.assign(st->size(),DlCost());
+	for (size_t i=0; i<recs.size(); i++)
+	{
+	    if (recs[i].node>=st->size())
+	    {
+		cerr << "Node " << recs[i].node << " is not in species tree " << s << endl;
+		exit(-1);
+	    }
+	    dist[recs[i].node]=recs[i].dl;
+	}
+	if (tree) st->pfcostdet(cout,&dist[0]);
+	else
+	{
+	    cout << *st << "\t" << endl; // as printsummary
+	    st->showcostdet(cout,&dist[0]);
+	}
+    }
+    return 0;
+}
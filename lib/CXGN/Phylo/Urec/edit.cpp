@@ -0,0 +1,262 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+// Edits of an unrooted gene tree: NNI, SPR, leaf insertion and deletion.
+//
+// A directed node u caches M, sc and cost of its side, the subtree away
+// from u->p(). An edit changes the sides of a few nodes around it (self):
+// their values are dropped. Then the nodes whose sides contain them are
+// visited, walking away from the edit. Their subtree costs are dropped,
+// and their mappings are recomputed on the way until one comes out
+// unchanged; beyond it the leaf sets, and so the mappings, are the old
+// ones. The walk ends at nodes with nothing cached. No lca is computed
+// outside the changed part; dropped costs are recomputed when asked for,
+// going down only through dropped nodes.
+//
+// An edit fixes the resolution of polytomies that rc has (adopt()) and
+// ends -H (clade ids). Other ReconcileContexts of the tree must be built
+// again. New nodes get the next ids, the last node takes the id of a
+// deleted one, and new edges get the next free eid().
+
+#include <string.h>
+#include <iostream>
+using namespace std;
+
+#include "urtree.h"
+
+void UTree::editing(ReconcileContext *rc)
+{
+    if (rc && rc->memo)
+    {
+	cerr << "Gene tree edits cannot be used with -H" << endl;
+	exit(-1);
+    }
+    polyv.clear();
+    cladev.clear();
+}
+
+// the tree takes the shape rc has for its species tree, see resolve()
+void UTree::adopt(ReconcileContext *rc)
+{
+    if (!rc || rc->pv.empty()) return;
+    if (rc->pruned)
+    {
+	cerr << "Gene tree edits cannot be used with -t" << endl;
+	exit(-1);
+    }
+    for (size_t i=0; i<nodev.size(); i++)
+    {
+	nodev[i]->p(rc->pv[i]);
+	nodev[i]->eid(rc->ev[i]);
+    }
+    start=rc->start();
+    rc->pv.clear();
+    rc->ev.clear();
+    rc->startn=NULL;
+    polyv.clear();
+}
+
+static void fitcontext(ReconcileContext *rc, size_t n)
+{
+    rc->Mn.resize(n);
+    rc->scn.resize(n);
+    rc->costn.resize(n);
+    rc->computed.resize(n);
+    rc->ismarked.resize(n);
+}
+
+void UTree::addnode(UNode *u, ReconcileContext *rc)
+{
+    u->id(nodev.size());
+    nodev.push_back(u);
+    if (rc) fitcontext(rc,nodev.size());
+}
+
+void UTree::removenode(UNode *u, ReconcileContext *rc)
+{
+    int i=u->id(), last=nodev.size()-1;
+    nodev[i]=nodev[last];
+    nodev[i]->id(i);
+    nodev.pop_back();
+    if (rc)
+    {
+	rc->Mn[i]=rc->Mn[last];
+	rc->scn[i]=rc->scn[last];
+	rc->costn[i]=rc->costn[last];
+	rc->computed[i]=rc->computed[last];
+	rc->ismarked[i]=rc->ismarked[last];
+	fitcontext(rc,last);
+    }
+    delete u;
+}
+
+// self: nodes whose sides changed; next: nodes whose sides are the same
+// but whose neighbours across the edge changed
+void UTree::changed(nodset &self, nodset &next, ReconcileContext *rc)
+{
+    if (!rc) return;
+    vector<pair<UNode*,int> > todo; // a node and whether the mappings beyond it may change
+    for (size_t i=0; i<self.size(); i++)
+    {
+	rc->computed[self[i]->id()]=0;
+	todo.push_back(make_pair(self[i],1));
+    }
+    for (size_t i=0; i<next.size(); i++) todo.push_back(make_pair(next[i],1));
+    while (todo.size())
+    {
+	UNode *x=todo.back().first;
+	int maps=todo.back().second;
+	todo.pop_back();
+	UNode *q=x->p();
+	if (!q) continue;
+	rc->computed[q->id()]&=~C_COST;
+	if (q->leaf()) continue;
+	UNode *y[2] = { ((UNode3*)q)->l(), ((UNode3*)q)->r() };
+	for (int k=0; k<2; k++)
+	{
+	    char &c=rc->computed[y[k]->id()], had=c;
+	    int m=0;
+	    if (maps && (c & C_MAP))
+	    {
+		RNode *old=rc->Mn[y[k]->id()];
+		c=0;
+		m = y[k]->M(*rc)!=old;
+	    }
+	    c&=C_MAP;
+	    // costs beyond need sc here, mappings beyond need this one
+	    if (m || (had & (C_SC|C_COST))) todo.push_back(make_pair(y[k],m));
+	}
+    }
+}
+
+// swaps the subtrees b and c, which hang on the two ends of an internal edge
+int UTree::nni(UNode *b, UNode *c, ReconcileContext *rc)
+{
+    adopt(rc);
+    if (!b->p() || !c->p() || b->p()->leaf() || c->p()->leaf()) return 0;
+    UNode3 *x=(UNode3*)b->p(), *y=(UNode3*)c->p();
+    UNode3 *u=NULL;
+    if (x->l()->p()==y->l() || x->l()->p()==y->r()) u=x->l();
+    else if (x->r()->p()==y->l() || x->r()->p()==y->r()) u=x->r();
+    if (!u) return 0;
+    editing(rc);
+    x->p(c);
+    c->p(x);
+    y->p(b);
+    b->p(y);
+    x->eid(c->eid());
+    y->eid(b->eid());
+    nodset self, next;
+    self.push_back(x);
+    self.push_back(y);
+    self.push_back(u);
+    self.push_back(u->p());
+    changed(self,next,rc);
+    return 1;
+}
+
+// whether the edge of e is on the side of s
+static int onside(UNode *s, UNode *e)
+{
+    UNode *f=e->p();
+    nodset todo(1,s);
+    while (todo.size())
+    {
+	UNode *x=todo.back();
+	todo.pop_back();
+	if (x==e || x==f) return 1;
+	if (x->leaf()) continue;
+	UNode3 *x3=(UNode3*)x;
+	if (x3->l()==e || x3->l()==f || x3->r()==e || x3->r()==f) return 1;
+	todo.push_back(x3->l()->p());
+	todo.push_back(x3->r()->p());
+    }
+    return 0;
+}
+
+// moves the subtree s onto the edge of e, which is neither in s nor next to it
+int UTree::spr(UNode *s, UNode *e, ReconcileContext *rc)
+{
+    adopt(rc);
+    if (!s->p() || s->p()->leaf() || !e->p()) return 0;
+    UNode3 *q=(UNode3*)s->p(), *q1=q->l(), *q2=q->r();
+    UNode *p1=q1->p(), *p2=q2->p(), *f=e->p();
+    if (e==p1 || e==p2 || f==p1 || f==p2 || onside(s,e)) return 0;
+    editing(rc);
+    // prune: the edges of q1 and q2 become one
+    p1->p(p2);
+    p2->p(p1);
+    int freed=p2->eid();
+    p2->eid(p1->eid());
+    // regraft
+    q1->p(e);
+    e->p(q1);
+    q2->p(f);
+    f->p(q2);
+    q1->eid(e->eid());
+    q2->eid(freed);
+    f->eid(freed);
+    nodset self, next;
+    self.push_back(q);
+    self.push_back(q1);
+    self.push_back(q2);
+    next.push_back(p1);
+    next.push_back(p2);
+    changed(self,next,rc);
+    return 1;
+}
+
+// a new leaf in the middle of the edge of e
+UNode *UTree::insertleaf(char *label, UNode *e, ReconcileContext *rc)
+{
+    adopt(rc);
+    if (!e->p()) return NULL;
+    editing(rc);
+    UNode *f=e->p();
+    UNode *l=createLeaf(label,strlen(label));
+    UNode3 *c=(UNode3*)createNode3(e,f), *a=c->l(), *b=c->r();
+    c->p(l);
+    l->p(c);
+    addnode(a,rc);
+    addnode(b,rc);
+    addnode(c,rc);
+    addnode(l,rc);
+    a->eid(e->eid());
+    b->eid(freeeid);
+    f->eid(freeeid++);
+    c->eid(freeeid);
+    l->eid(freeeid++);
+    nodset self, next;
+    self.push_back(a);
+    self.push_back(b);
+    changed(self,next,rc);
+    return l;
+}
+
+// a tree keeps at least two leaves
+int UTree::deleteleaf(UNode *l, ReconcileContext *rc)
+{
+    adopt(rc);
+    if (!l->leaf() || !l->p() || l->p()->leaf()) return 0;
+    editing(rc);
+    UNode3 *c=(UNode3*)l->p(), *a=c->l(), *b=c->r();
+    UNode *p1=a->p(), *p2=b->p();
+    p1->p(p2);
+    p2->p(p1);
+    p2->eid(p1->eid());
+    if (start==l || start==a || start==b || start==c) start=p1;
+    removenode(l,rc);
+    removenode(a,rc);
+    removenode(b,rc);
+    removenode(c,rc);
+    nodset self, next;
+    next.push_back(p1);
+    next.push_back(p2);
+    changed(self,next,rc);
+    return 1;
+}
@@ -0,0 +1,167 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "loader.h"
+#include "parallel.h"
+#include "bintree.h"
+#include "zstream.h"
+
+// "-" reads standard input; lines may be of any length; compressed files
+// are decompressed while they are parsed
+void readgtree_fgets(char *fn, utreevec &gtset)
+{
+    FILE *f;
+    f= zopen(fn,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    readgtree_fgets(f,gtset);
+}
+
+// the rest of f, which is closed
+void readgtree_fgets(FILE *f, utreevec &gtset)
+{
+    char *buf=NULL;
+    size_t len=0;
+    while (getline(&buf,&len,f)>=0)
+    {
+	if (strspn(buf," \t\r\n")==strlen(buf)) continue;
+	gtset.push_back(new UTree(buf));
+    }
+    free(buf);
+    fclose(f);
+}
+
+// One chunk is a run of whole lines of the mapped file. Every chunk gets
+// its own tree list, so the workers never share anything but the
+// (read-only) mapping; the lists are concatenated in chunk order afterwards.
+struct ChunkParser
+{
+    const char *data;
+    vector<size_t> bound;
+    vector<utreevec> trees;
+
+    void operator()(int c, int tid)
+    {
+	string buf;
+	size_t p=bound[c], end=bound[c+1];
+	while (p<end)
+	{
+	    const char *nl = (const char*)memchr(data+p,'\n',end-p);
+	    size_t e = nl ? nl-data : end;
+	    // the parser needs a terminated string and must not run into the next line
+	    buf.assign(data+p,e-p);
+	    if (buf.find_first_not_of(" \t\r")!=string::npos)
+		trees[c].push_back(new UTree((char*)buf.c_str()));
+	    p=e+1;
+	}
+    }
+};
+
+// returns 0 if the file cannot be mapped (pipes etc.)
+int readgtree_mmap(char *fn, utreevec &gtset)
+{
+    int fd = open(fn,O_RDONLY);
+    if (fd<0)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    struct stat st;
+    if ((fstat(fd,&st)<0) || !S_ISREG(st.st_mode)) { close(fd); return 0; }
+    size_t size = st.st_size;
+    if (!size) { close(fd); return 1; }
+    void *m = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (m==MAP_FAILED) return 0;
+    madvise(m,size,MADV_SEQUENTIAL);
+
+    ChunkParser cp;
+    cp.data=(const char*)m;
+    int nchunks = threadcount()*4;
+    cp.bound.push_back(0);
+    for (int i=1; i<nchunks; i++)
+    {
+	size_t b = size/nchunks*i;
+	if (b<cp.bound.back()) b=cp.bound.back();
+	const char *nl = (const char*)memchr(cp.data+b,'\n',size-b);
+	cp.bound.push_back(nl ? nl-cp.data+1 : size);
+    }
+    cp.bound.push_back(size);
+    cp.trees.resize(nchunks);
+
+    parallel_for(nchunks,cp);
+
+    for (int i=0; i<nchunks; i++)
+	gtset.insert(gtset.end(),cp.trees[i].begin(),cp.trees[i].end());
+    munmap(m,size);
+    return 1;
+}
+
+void readgtree(char *fn, utreevec &gtset)
+{
+    FILE *f = zopen(fn,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    if (isbinary(f))
+    {
+	readgtree_bin(f,fn,gtset);
+	return;
+    }
+    // zopen() gives a plain regular file as it is, the only kind mapped
+    struct stat st;
+    if (!zcompressed(f) && (fstat(fileno(f),&st)==0) && S_ISREG(st.st_mode) && (st.st_size>=MMAP_MINSIZE) && readgtree_mmap(fn,gtset))
+    {
+	fclose(f);
+	return;
+    }
+    readgtree_fgets(f,gtset);
+}
+
+void readfamilies(char *fn, utreevec &gtset, vector<string> &fam)
+{
+    FILE *f = zopen(fn,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    char *buf=NULL;
+    size_t len=0;
+    while (getline(&buf,&len,f)>=0)
+    {
+	char *id=buf+strspn(buf," \t\r\n");
+	if (!*id) continue;
+	char *t=id+strcspn(id," \t\r\n");
+	if (!*t || !t[strspn(t," \t\r\n")])
+	{
+	    cerr << "Family and tree expected: " << buf;
+	    exit(-1);
+	}
+	fam.push_back(string(id,t-id));
+	gtset.push_back(new UTree(t+strspn(t," \t")));
+    }
+    free(buf);
+    fclose(f);
+}
@@ -0,0 +1,24 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _LOADER__
+#define _LOADER__
+
+#include "urtree.h"
+
+// files at least this large are memory-mapped and parsed in parallel
+#define MMAP_MINSIZE (1<<20)
+
+void readgtree(char *fn, utreevec &gtset);
+void readgtree_fgets(char *fn, utreevec &gtset);
+void readgtree_fgets(FILE *f, utreevec &gtset);
+int readgtree_mmap(char *fn, utreevec &gtset);
+// lines "family tree": the family of every tree read is appended to fam
+void readfamilies(char *fn, utreevec &gtset, vector<string> &fam);
+
+#endif
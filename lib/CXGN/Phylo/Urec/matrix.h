@@ -0,0 +1,32 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _MATRIX__
+#define _MATRIX__
+
+#include <stdint.h>
+
+// Cost matrix files (-M), to be mapped as they are by other programs:
+//
+//   MatrixHeader
+//   int32_t [genes][species][2]    dup and loss of the optimal rooting
+//
+// so the pair of gene tree g and species tree s is at (g*species+s)*2
+// after the header. Both count the trees from 0 in input order. Integers
+// are in the byte order of the machine that wrote the file.
+
+#define MATRIX_MAGIC "URECMAT\1"
+#define MATRIX_MAGICLEN 8
+
+typedef struct MatrixHeader
+{
+    char magic[MATRIX_MAGICLEN];
+    int32_t genes, species;
+} MatrixHeader;
+
+#endif
@@ -0,0 +1,73 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+// urec-merge: the summary output of a run split by urec -J
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+using namespace std;
+
+#include "rtree.h"
+#include "summary.h"
+#include "options.h"
+
+int main(int argc, char **argv)
+{
+    if (argc<2)
+    {
+	cout << " Usage: " << argv[0] << " shardfile ..." << endl;
+	cout << " Adds up the files of urec -J i/N,file, all N of them, and prints what" << endl;
+	cout << " -v, -c, -C, -d and -x print for the whole run" << endl;
+	exit(-1);
+    }
+    int n=argc-1;
+    vector<ShardResults> r(n);
+    int first=-1;
+    for (int i=0; i<n; i++)
+    {
+	ShardResults s;
+	loadshard(argv[i+1],s);
+	if (s.shards!=n)
+	{
+	    cerr << argv[i+1] << " is one of " << s.shards << " shards, " << n << " given" << endl;
+	    exit(-1);
+	}
+	if (r[s.shard].species.size())
+	{
+	    cerr << "Shard " << s.shard << " given twice" << endl;
+	    exit(-1);
+	}
+	ShardResults &f=first<0 ? s : r[first];
+	if (s.genopt!=f.genopt || s.nweights!=f.nweights || s.dupweight!=f.dupweight || s.lossweight!=f.lossweight ||
+	    s.gtrees!=f.gtrees || s.species!=f.species)
+	{
+	    cerr << argv[i+1] << " belongs to another run" << endl;
+	    exit(-1);
+	}
+	r[s.shard]=s;
+	if (first<0) first=s.shard;
+    }
+
+    // in shard order, as a single run would add them
+    vector<SpeciesSummary> sum=r[0].sum;
+    for (int i=1; i<n; i++)
+	for (size_t k=0; k<sum.size(); k++) sum[k].add(r[i].sum[k]);
+
+    weight_dup=r[0].dupweight;
+    weight_loss=r[0].lossweight;
+    int intweights=integralweights();
+    int genopt=r[0].genopt;
+    vector<SpeciesTree*> stv;
+    for (size_t k=0; k<sum.size(); k++) stv.push_back(new SpeciesTree((char*)r[0].species[k].c_str()));
+    if (genopt & OPT_VOTING)
+	for (size_t k=0; k<sum.size(); k++) cout << *stv[k] << " " << sum[k].votes << endl;
+    if (genopt & OPT_BYCOST)
+	for (size_t k=0; k<sum.size(); k++) printsummary(stv[k],genopt,intweights,sum[k]);
+    return 0;
+}
@@ -0,0 +1,41 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _OPTIONS__
+#define _OPTIONS__
+
+// genopt bits of urec, also read by urec-merge
+
+#define OPT_RECDETAILS 1
+#define OPT_RECINFO 2
+#define OPT_PRINTROOTED 4 
+#define OPT_RECMINROOTING 8
+#define OPT_RECTREECOSTDETAILS 16
+#define OPT_PRINTGENE 32
+#define OPT_PRINTSPECIES 64
+#define OPT_RECMINCOST 128
+#define OPT_SUMMARYTOTAL 256
+#define OPT_SUMMARYDISTRIBUTIONS 512
+#define OPT_SUMMARYDLTOTAL (1<<12)
+#define OPT_TREEDISTRIBUTIONS (1<<13)
+#define OPT_VOTING (1<<14)
+#define OPT_BYCOST (1<<15)
+#define OPT_RANDUNIQUE (1<<16)
+#define OPT_HASHCONS (1<<17)
+#define OPT_PROJECT (1<<18)
+#define OPT_DISTFILE (1<<19)
+#define OPT_EVENTS (1<<20)
+
+// need the gene tree in the shape of each reconciliation, so -b goes
+// pair by pair; without them all pairs are computed at once (PairCosts)
+#define OPT_PAIRBYPAIR (OPT_RECDETAILS|OPT_RECINFO|OPT_RECMINROOTING|OPT_RECTREECOSTDETAILS|OPT_SUMMARYDISTRIBUTIONS|OPT_TREEDISTRIBUTIONS|OPT_DISTFILE|OPT_EVENTS)
+
+#define FMT_TSV 1
+#define FMT_JSON 2
+
+#endif
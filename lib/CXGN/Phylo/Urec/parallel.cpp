@@ -0,0 +1,81 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <unistd.h>
+#include "parallel.h"
+
+int num_threads=0;
+
+int threadcount()
+{
+    if (num_threads>0) return num_threads;
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n>0 ? (int)n : 1;
+}
+
+long cachesize()
+{
+    long c=0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    c=sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    return c>0 ? c : 1<<20;
+}
+
+// bound: 0, the starts of the blocks, w.size(); a block ends before it
+// would get heavier than max and has at least one item
+void tileblocks(vector<long> &w, long max, vector<int> &bound)
+{
+    bound.assign(1,0);
+    long b=0;
+    for (size_t i=0; i<w.size(); i++)
+    {
+	if (b && b+w[i]>max) { bound.push_back(i); b=0; }
+	b+=w[i];
+    }
+    bound.push_back(w.size());
+}
+
+TileDeques::TileDeques(int n, int gblocks, int sblocks) : q(n), m(n)
+{
+    for (int i=0; i<n; i++)
+    {
+	pthread_mutex_init(&m[i],NULL);
+	for (int g=(long)gblocks*i/n; g<(long)gblocks*(i+1)/n; g++)
+	    for (int s=0; s<sblocks; s++)
+	    {
+		Tile t = { g, s };
+		q[i].push_back(t);
+	    }
+    }
+}
+
+TileDeques::~TileDeques()
+{
+    for (size_t i=0; i<m.size(); i++) pthread_mutex_destroy(&m[i]);
+}
+
+int TileDeques::take(int i, Tile &t)
+{
+    int n=q.size();
+    for (int k=0; k<n; k++)
+    {
+	int v=(i+k)%n;
+	pthread_mutex_lock(&m[v]);
+	int got=!q[v].empty();
+	if (got)
+	{
+	    // the owner from the front, a thief from the back
+	    if (!k) { t=q[v].front(); q[v].pop_front(); }
+	    else { t=q[v].back(); q[v].pop_back(); }
+	}
+	pthread_mutex_unlock(&m[v]);
+	if (got) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _PARALLEL__
+#define _PARALLEL__
+
+#include <pthread.h>
+#include <vector>
+#include <deque>
+using namespace std;
+
+extern int num_threads; // -j; 0 means one thread per online cpu
+int threadcount();
+
+// parallel_for(n,f) calls f(i,tid) for every 0<=i<n; the indices are handed
+// out one at a time, so slow items do not hold up a whole block.
+// tid is in [0,threadcount()) and can be used to select per-thread state.
+
+template<class F> struct ParallelJob
+{
+    F *f;
+    int n;
+    volatile int next;
+};
+
+template<class F> struct ParallelWorker
+{
+    ParallelJob<F> *job;
+    int tid;
+};
+
+template<class F> void *parallel_run(void *a)
+{
+    ParallelWorker<F> *w = (ParallelWorker<F>*)a;
+    ParallelJob<F> *job = w->job;
+    int i;
+    while ((i=__sync_fetch_and_add(&job->next,1)) < job->n)
+	(*job->f)(i,w->tid);
+    return NULL;
+}
+
+template<class F> void parallel_for(int n, F &f)
+{
+    int tn = threadcount();
+    if (tn>n) tn=n;
+    if (tn<=1)
+    {
+	for (int i=0; i<n; i++) f(i,0);
+	return;
+    }
+    ParallelJob<F> job;
+    job.f=&f;
+    job.n=n;
+    job.next=0;
+    vector<pthread_t> th(tn);
+    vector<ParallelWorker<F> > w(tn);
+    int i;
+    for (i=0; i<tn; i++) { w[i].job=&job; w[i].tid=i; }
+    for (i=1; i<tn; i++)
+	pthread_create(&th[i],NULL,parallel_run<F>,&w[i]);
+    parallel_run<F>(&w[0]);
+    for (i=1; i<tn; i++) pthread_join(th[i],NULL);
+}
+
+// parallel_tiles(gw,sw,f) calls f(g,s,tid) for every gene tree g and
+// species tree s, gw[g] and sw[s] being their sizes in bytes. Both sets are
+// cut into consecutive blocks of about half the L2 cache, and a tile (gene
+// block x species block) is done before the next, so its trees stay in the
+// cache. Every thread starts with a deque of the tiles of its own run of
+// gene blocks and takes them from the front, species blocks inner; a thread
+// whose deque is empty steals from the back of another one, so the tiles
+// of trees of different sizes even out without sharing a counter.
+
+long cachesize();
+void tileblocks(vector<long> &w, long max, vector<int> &bound);
+
+typedef struct Tile
+{
+    int g, s; // gene block, species block
+} Tile;
+
+class TileDeques
+{
+    vector<deque<Tile> > q;
+    vector<pthread_mutex_t> m;
+ public:
+    // the gene blocks are dealt to n deques in runs, each with all species blocks
+    TileDeques(int n, int gblocks, int sblocks);
+    ~TileDeques();
+    // the next tile of deque i, or one stolen from another; 0 when all are done
+    int take(int i, Tile &t);
+};
+
+template<class F> struct TileRunner
+{
+    F &f;
+    vector<int> gb, sb; // block boundaries
+    TileDeques *q;
+    TileRunner(F &f_) : f(f_), q(NULL) {}
+    void operator()(int i, int tid)
+    {
+	Tile t;
+	while (q->take(i,t))
+	    for (int g=gb[t.g]; g<gb[t.g+1]; g++)
+		for (int s=sb[t.s]; s<sb[t.s+1]; s++)
+		    f(g,s,tid);
+    }
+};
+
+template<class F> void parallel_tiles(vector<long> &gw, vector<long> &sw, F &f)
+{
+    TileRunner<F> r(f);
+    long c=cachesize()/2, total=0;
+    for (size_t i=0; i<gw.size(); i++) total+=gw[i];
+    int tn=threadcount();
+    long gmax=total/(4*tn);
+    if (gmax>c) gmax=c;
+    tileblocks(gw,gmax,r.gb);
+    tileblocks(sw,c,r.sb);
+    TileDeques q(tn,r.gb.size()-1,r.sb.size()-1);
+    r.q=&q;
+    parallel_for(tn,r);
+}
+
+#endif
@@ -9,7 +9,12 @@
  *************************************************************************/
 
 #include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <iostream>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 
 using namespace std;
 
@@ -17,27 +22,211 @@ using namespace std;
 
 double weight_loss=1.0;
 double weight_dup=1.0;
+long IntWeights::dup=1;
+long IntWeights::loss=1;
 
-char* getTok(char *s,int &p) // skip spaces, return next char (if alphabetic or (),) then 
+// if the weights are integers, set up IntWeights and return 1
+int integralweights()
 {
-	// return pointer to pth char of s, i.e. s+p, and also p is reset s.t. s+p is the char after the (),  or after a string of other chars
-#define inctok p++  // inctok increments p
-	while ((isspace(s[p])) ||( s[p] == '\n') || (s[p] == '\t')){ inctok; } // skip over spaces, and newlines
-	char *cur = s+p; // cur points to first non-space char encountered.
-	if (isalpha(s[p]) or (s[p] == ':')) // if s[p] is alphabetic
+	if ((weight_dup!=(int)weight_dup) || (weight_loss!=(int)weight_loss)) return 0;
+	IntWeights::dup=(long)weight_dup;
+	IntWeights::loss=(long)weight_loss;
+	return 1;
+}
+
+// Newick tokens. Blanks and [comments] between tokens are skipped. A label
+// is everything up to the next ( ) , or ; - 'quoted' parts (with '' for a
+// quote), [annotations] and the :length included - without trailing blanks.
+static void skipblank(char *s, int &p)
+{
+	while (1)
 		{
-			while( !( (s[p]=='(')  || (s[p]==')') || (s[p]==',') ) ) inctok; // sets p s.t. s+p points to next )( or ,
-			return cur; // cur points to an alphabetic char
+			while (isspace(s[p])) p++;
+			if (s[p]!='[') return;
+			while (s[p] && (s[p]!=']')) p++;
+			if (s[p]) p++;
 		}
+}
+
+static int structural(char c) { return (c=='(') || (c==')') || (c==',') || (c==';'); }
+
+// skips to the next token and tells whether it is a label
+int islabel(char *s, int &p)
+{
+	skipblank(s,p);
+	return s[p] && !structural(s[p]);
+}
+
+char* getTok(char *s,int &p) // returns s+p of the next token; p is set to the char after it
+{
+	skipblank(s,p);
+	char *cur = s+p;
 	if ((s[p]=='(')  || (s[p]==')') || (s[p]==','))
 		{
-			inctok;
+			p++;
 			return cur; // cur points to a )( or ,  ; s+p points to next char
 		}
-	cerr << "Parse error...s[p]: [" << s[p] << "]"<< endl;
+	if (!s[p] || (s[p]==';'))
+		{
+			cerr << "Parse error: unexpected end of tree" << endl;
+			exit(-1);
+		}
+	int end=p;
+	while (s[p] && !structural(s[p]))
+		{
+			if ((s[p]=='\'') || (s[p]=='['))
+				{
+					char close = (s[p]=='[') ? ']' : '\'';
+					for (p++; s[p] && !((s[p]==close) && (s[p+1]!=close || close==']')); p++)
+						if ((close=='\'') && (s[p]=='\'')) p++; // ''
+					if (!s[p])
+						{
+							cerr << "Parse error: unterminated " << (close==']' ? "[" : "quote") << " in " << cur << endl;
+							exit(-1);
+						}
+					end=++p;
+					continue;
+				}
+			if (!isspace(s[p])) end=p+1;
+			p++;
+		}
+	p=end;
+	return cur;
+}
+
+static void parseerror(const char *what, const char *at)
+{
+	cerr << "Parse error: " << what << " at " << string(at,strnlen(at,40)) << endl;
 	exit(-1);
 }
 
+// the token starting a node: ( or its label, which cannot be empty
+char* nodeTok(char *s,int &p)
+{
+	char *cur = getTok(s,p);
+	if ((cur[0]==',') || (cur[0]==')')) parseerror("empty label",cur);
+	return cur;
+}
+
+// the token after the nkids-th child of a node: , or the closing ) once
+// there are two children at least
+char* closeTok(char *s,int &p,int nkids)
+{
+	char *cur = getTok(s,p);
+	if ((cur[0]==')') && (nkids<2)) parseerror("a node needs two children",cur);
+	if ((cur[0]!=',') && (cur[0]!=')')) parseerror(", or ) expected",cur);
+	return cur;
+}
+
+// after the root only a ; and blanks may follow
+void endTree(char *s,int p)
+{
+	skipblank(s,p);
+	if (s[p]==';') p++;
+	skipblank(s,p);
+	if (s[p]) parseerror("unexpected text after the tree",s+p);
+}
+
+// variant -> standard species name, both in standardformat(); NULL without -m
+static unordered_map<string,string> *speciesmap=NULL;
+
+// Species_name_map::to_standard_format: words split at whitespace and _,
+// lower case, joined by _, the first letter upper case
+static string standardformat(const char *s, int len)
+{
+	string r;
+	for (int i=0; i<len; i++)
+		{
+			if (isspace(s[i]) || s[i]=='_')
+				{
+					if (r.size() && r[r.size()-1]!='_') r+='_';
+					continue;
+				}
+			r+=tolower(s[i]);
+		}
+	if (r.size() && r[r.size()-1]=='_') r.erase(r.size()-1);
+	if (r.size()) r[0]=toupper(r[0]);
+	return r;
+}
+
+// The format of Species_name_map::get_map_string, (a => b, c => d), or
+// one variant => standard pair per line
+void loadspeciesmap(const char *fn)
+{
+	FILE *f=fopen(fn,"r");
+	if (!f)
+		{
+			cerr << "Cannot open file " << fn << endl;
+			exit(-1);
+		}
+	string t;
+	char buf[4096];
+	size_t r;
+	while ((r=fread(buf,1,sizeof(buf),f))>0) t.append(buf,r);
+	fclose(f);
+	if (!speciesmap) speciesmap=new unordered_map<string,string>;
+	size_t b=t.find_first_not_of(" \t\r\n(");
+	while (b<t.size())
+		{
+			size_t e=t.find_first_of(",\n)",b);
+			if (e==string::npos) e=t.size();
+			string p=t.substr(b,e-b);
+			size_t a=p.find("=>");
+			if (a!=string::npos)
+				(*speciesmap)[standardformat(p.c_str(),a)]=standardformat(p.c_str()+a+2,p.size()-a-2);
+			else if (p.find_first_not_of(" \t\r")!=string::npos)
+				{
+					cerr << "variant => standard expected in " << fn << ": " << p << endl;
+					exit(-1);
+				}
+			b=t.find_first_not_of(" \t\r\n,)",e);
+		}
+}
+
+// Name and species of a leaf label such as 'Gene 1'[species=Homo sapiens]:0.1.
+// The species is the name if there is no (or an empty) species annotation.
+void leaflabel(const char *l, char *&name, char *&species)
+{
+	string n;
+	int p=0;
+	if (l[p]=='\'')
+		for (p++; l[p]; p++)
+			{
+				if (l[p]=='\'')
+					{
+						if (l[p+1]!='\'') { p++; break; }
+						p++;
+					}
+				n+=l[p];
+			}
+	else
+		while (l[p] && !isspace(l[p]) && (l[p]!='[') && (l[p]!=':')) n+=l[p++];
+	name=xstrndup(n.c_str(),0);
+
+	const char *a=l+p;
+	while ((a=strstr(a,"species="))!=NULL)
+		{
+			if (strchr("[;,: \t",a[-1])) break;
+			a++;
+		}
+	int len=0;
+	if (a)
+		{
+			a+=strlen("species=");
+			while (isspace(*a)) a++;
+			len=strcspn(a,";,]");
+			while (len && isspace(a[len-1])) len--;
+		}
+	species = len ? xstrndup(a,len) : xstrndup(n.c_str(),0);
+	if (speciesmap)
+		{
+			string s=standardformat(species,strlen(species));
+			unordered_map<string,string>::iterator i=speciesmap->find(s);
+			free(species);
+			species=xstrndup(i==speciesmap->end() ? s.c_str() : i->second.c_str(),0);
+		}
+}
+
 iterator_tree::iterator_tree(RTree *tr, int flag_) 
 { 
 	t=tr; 
@@ -48,16 +237,20 @@ iterator_tree::iterator_tree(RTree *tr, int flag_)
 RNode *RTree::parseNode(char *s,int &p)
 {
 	// 
-	char *cur = getTok(s,p);
+	char *cur = nodeTok(s,p);
 	if (cur[0]=='(')
 		{
 			RNode *a = parseNode(s,p);
-			cur = getTok(s,p);
+			cur = closeTok(s,p,1);
 			RNode *b = parseNode(s,p);
-			cur = getTok(s,p);
-			if(s[p]==':'){ 
-				int start = p; getTok(s,p); 
-				return createInt(a,b,s+start,p-start) ; 
+			if (closeTok(s,p,2)[0]==',')
+				{
+					cerr << "Species trees must be binary" << endl;
+					exit(-1);
+				}
+			if(islabel(s,p)){ 
+				char *l = getTok(s,p); 
+				return createInt(a,b,l,s+p-l) ; 
 			}
 			else{ 
 				RNode* c = createInt(a,b);
@@ -72,7 +265,26 @@ RTree::RTree(char *fs)
 {
 	int px=0;
 	rootn=parseNode(fs,px);
+	endTree(fs,px);
 	rootn->depth(0);
+	number();
+}
+
+RTree::~RTree()
+{
+	for (size_t i=0; i<nodev.size(); i++) delete nodev[i];
+}
+
+void RTree::number()
+{
+	nodev.clear();
+	iterator_tree it(this);
+	RNode *n;
+	while ((n=it())!=0)
+	{
+		n->id(nodev.size());
+		nodev.push_back(n);
+	}
 }
 
 RNode *iterator_tree::operator()()
@@ -120,6 +332,87 @@ RNode *SpeciesTree::lca(RNode *a, RNode *b) {
 	return NULL;
 }
 
+void SpeciesTree::tour(RNode *n)
+{
+	first[n->id()]=euler.size();
+	euler.push_back(n->id());
+	sizev[n->id()]=1;
+	if (n->leaf()) return;
+	RNode *c[2] = { ((RInt*)n)->l(), ((RInt*)n)->r() };
+	for (int i=0; i<2; i++)
+	{
+		tour(c[i]);
+		sizev[n->id()]+=sizev[c[i]->id()];
+		euler.push_back(n->id());
+	}
+}
+
+void SpeciesTree::preparelca()
+{
+	if (!euler.empty()) return;
+	sizev.resize(size());
+	first.resize(size());
+	tour(rootn);
+	// sparse[k][i]: the shallowest node of euler[i..i+2^k)
+	sparse.push_back(euler);
+	for (int k=1; (1<<k)<=(int)euler.size(); k++)
+	{
+		vector<int> &prev=sparse[k-1];
+		vector<int> cur(euler.size()-(1<<k)+1);
+		for (size_t i=0; i<cur.size(); i++)
+		{
+			int a=prev[i], b=prev[i+(1<<(k-1))];
+			cur[i] = (nodev[a]->depth()<=nodev[b]->depth()) ? a : b;
+		}
+		sparse.push_back(cur);
+	}
+}
+
+RNode *SpeciesTree::fastlca(RNode *a, RNode *b)
+{
+	int i=first[a->id()], j=first[b->id()];
+	if (i>j) { int t=i; i=j; j=t; }
+	int k=0;
+	while ((2<<k)<=j-i+1) k++;
+	int x=sparse[k][i], y=sparse[k][j-(1<<k)+1];
+	return nodev[x]->depth()<=nodev[y]->depth() ? nodev[x] : nodev[y];
+}
+
+static int preorder(RNode *a, RNode *b) { return a->id()<b->id(); }
+
+// the leaves and the LCAs of neighbours in pre-order are closed under LCA;
+// the induced tree is built with a stack of ancestors, O(k log k) in total
+RNode *ProjectedTree::project(SpeciesTree *full, vector<RNode*> &leaves)
+{
+	vector<RNode*> v(leaves);
+	sort(v.begin(),v.end(),preorder);
+	v.erase(unique(v.begin(),v.end()),v.end());
+	size_t k=v.size();
+	for (size_t i=0; i+1<k; i++) v.push_back(full->fastlca(v[i],v[i+1]));
+	sort(v.begin(),v.end(),preorder);
+	v.erase(unique(v.begin(),v.end()),v.end());
+
+	vector<int> parent(v.size(),-1);
+	vector<int> stack;
+	for (size_t i=0; i<v.size(); i++)
+	{
+		while (!stack.empty() && !full->isancestor(v[stack.back()],v[i])) stack.pop_back();
+		if (!stack.empty()) parent[i]=stack.back();
+		stack.push_back(i);
+	}
+	// children come after their parent in pre-order, so build from the end;
+	// every internal node of the induced tree has exactly two children
+	vector<RNode*> node(v.size());
+	vector< vector<RNode*> > kids(v.size());
+	for (size_t i=v.size(); i-->0; )
+	{
+		if (v[i]->leaf()) node[i]=new PLeaf((RLeaf*)v[i]);
+		else node[i]=new PInt(kids[i][1],kids[i][0],v[i]);
+		if (parent[i]>=0) kids[parent[i]].push_back(node[i]);
+	}
+	return node[0];
+}
+
 RNode *RNode::isParentOf(RNode *c) 
 { 
 	while (c) { 
@@ -132,7 +425,7 @@ RNode *RNode::isParentOf(RNode *c)
 char* xstrndup(const char *s,int len)
 {
 	if (len==0) return strdup(s);
-	char *b = new char[len+1];
+	char *b = (char*)malloc(len+1); // always malloc'ed, so that free() works for both cases
 	strncpy(b,s,len);
 	b[len]=0;
 	return b;
@@ -16,9 +16,19 @@
 
 #include <iostream>
 #include <map>
+#include <vector>
+#include <string.h>
 using namespace std;
 
 char* getTok(char *s,int &p);
+char* nodeTok(char *s,int &p);
+char* closeTok(char *s,int &p,int nkids);
+void endTree(char *s,int p);
+int islabel(char *s, int &p);
+void leaflabel(const char *l, char *&name, char *&species);
+// -m: species names of leaves are standardized as CXGN::Phylo::Species_name_map
+// does, with the map of the file, from then on
+void loadspeciesmap(const char *fn);
 char* xstrndup(const char *s,int len);
 
 extern double weight_loss;
@@ -36,6 +46,25 @@ typedef struct DlCost
 	double mut() { return weight_dup*dup+weight_loss*loss; }
 } DlCost;
 
+// Cost policies: how the engine turns a DlCost into the mutation cost it
+// minimizes and compares. IntWeights is used when -D and -L are integral
+// (the default is 1,1), so sums and ties are exact integer arithmetic;
+// RealWeights is the double arithmetic of DlCost::mut().
+struct IntWeights
+{
+	typedef long value;
+	static long dup, loss;
+	static value mut(const DlCost &c) { return dup*c.dup+loss*c.loss; }
+};
+
+struct RealWeights
+{
+	typedef double value;
+	static value mut(const DlCost &c) { return weight_dup*c.dup+weight_loss*c.loss; }
+};
+
+int integralweights();
+
 class RInt;
 
 class RNode // rooted node, I guess
@@ -43,28 +72,30 @@ class RNode // rooted node, I guess
 	protected:
 		RInt *pn;
 		int depthn;
-		DlCost dc;
+		int idn; // pre-order index in its tree; indexes distribution arrays
 		char* complete_label; 
 	public:
 		RNode() { pn=NULL; }
-		virtual ~RNode() {}
+		virtual ~RNode() { free(complete_label); }
 		virtual int leaf() { return 0; }
 		//		virtual ostream& print(ostream&s)  { return s; }
 		int depth() { return depthn; }
 		virtual void depth(int d) { depthn=d; }
+		int id() { return idn; }
+		void id(int i) { idn=i; }
 		friend ostream& operator<<(ostream&s, RNode &p)  { return p.print(s); }  
 		virtual RInt *p() { return pn; }
 		virtual void p(RInt *p) { pn=p; }
 		RNode *isParentOf(RNode *c);
-		DlCost &costdet() { return dc; }
+		virtual RNode *orig() { return this; } // the node of the full species tree (see ProjectedTree)
 
 	virtual ostream& print(ostream&s)  { 
 			return s << OUT_LABEL << "\n";
 		}    
-		virtual void showcostdet(ostream&s) { s << dc << " : "; print(s); s << endl; }
-		virtual DlCost subtreecost()=0; 
-		virtual void pfcostdet(ostream&s) {  
-			s << " dup(" << dc.dup << ")" << " loss(" << dc.loss <<")"; };
+		virtual void showcostdet(ostream&s, DlCost *dc) { s << dc[idn] << " : "; print(s); s << endl; }
+		virtual DlCost subtreecost(DlCost *dc)=0; 
+		virtual void pfcostdet(ostream&s, DlCost *dc) {  
+			s << " dup(" << dc[idn].dup << ")" << " loss(" << dc[idn].loss <<")"; };
 };
 
 class RInt : public RNode // rooted internal node?
@@ -75,11 +106,11 @@ class RInt : public RNode // rooted internal node?
 
  public:
 		RInt(RNode *_l,RNode *_r) : RNode(), ln(_l), rn(_r) 
-			{ ln->p(this); rn->p(this);  complete_label = "";   }
+			{ ln->p(this); rn->p(this);  complete_label = xstrndup("",0);   }
 			RInt(RNode *_l,RNode *_r, char* s, int len) : RNode(), ln(_l), rn(_r)
 				{ ln->p(this); rn->p(this); 
 					if(s != NULL && len > 0){ complete_label = xstrndup(s,len); }				 
-					else{ complete_label = ""; }
+					else{ complete_label = xstrndup("",0); }
 				}
 				virtual void depth(int d) { depthn=d; ln->depth(d+1); rn->depth(d+1); }
 				~RInt() {}
@@ -90,19 +121,19 @@ class RInt : public RNode // rooted internal node?
 					if(SHOW_INTERIOR_LABELS){ s << OUT_LABEL; }
 					return s; 
 				}      
-				virtual void showcostdet(ostream&s) { 
-			RNode::showcostdet(s);
-			ln->showcostdet(s);
-			rn->showcostdet(s);
+				virtual void showcostdet(ostream&s, DlCost *dc) { 
+			RNode::showcostdet(s,dc);
+			ln->showcostdet(s,dc);
+			rn->showcostdet(s,dc);
 		}
-		virtual DlCost subtreecost() { return ln->subtreecost() + dc + rn->subtreecost(); }
-		virtual void pfcostdet(ostream&s) { 
+		virtual DlCost subtreecost(DlCost *dc) { return ln->subtreecost(dc) + dc[idn] + rn->subtreecost(dc); }
+		virtual void pfcostdet(ostream&s, DlCost *dc) { 
 			s << "(";  
-			ln->pfcostdet(s);   	
+			ln->pfcostdet(s,dc);   	
 			s << ",";  
-			rn->pfcostdet(s);   	
+			rn->pfcostdet(s,dc);   	
 			s << ")";
-			RNode::pfcostdet(s); 
+			RNode::pfcostdet(s,dc); 
 		} 
 };
 
@@ -116,35 +147,34 @@ class RLeaf : public RNode
 		//	char* complete_label; // something like At435[species=Arabidopsis_thaliana]:0.1 in RNode
 	public:
 		RLeaf(char*l) : RNode(), lab(l) {
-			char* label_copy = xstrndup(l,0);
 			complete_label = xstrndup(l,0);
-			char* label = strtok(label_copy, " [:"); // everything up to first space : or [
-			gene_id = xstrndup(label, 0); 
-			char* attrib_name = strtok(NULL, " [="); 
-			char* attrib_value;
-			if((attrib_name == NULL) ||  (strcmp(attrib_name, "species") != 0)  ||	( (attrib_value = strtok(NULL, " =]")) == NULL) ){
-				lab = xstrndup(label, 0);
-			}
-			else{ // [species=something] present. use it.		
-				lab = xstrndup(attrib_value, 0);
-			}
-			free(label_copy);
+			leaflabel(l,gene_id,lab);
+			free(l);
 		}
-		~RLeaf() {}
+		// an already split label (see leaflabel)
+		RLeaf(const char *complete, const char *name, const char *species) : RNode() {
+			complete_label = xstrndup(complete,0);
+			gene_id = xstrndup(name,0);
+			lab = xstrndup(species,0);
+		}
+		// the labels of o, not split again
+		RLeaf(RLeaf *o) : RLeaf(o->complete_label,o->gene_id,o->lab) {}
+		~RLeaf() { free(lab); free(gene_id); }
 		virtual int leaf() { return 1; }
 		char* label() { return lab; }
 		virtual ostream& print(ostream&s)  { 
 			return s << OUT_LABEL; // 
 		}    
-		virtual DlCost subtreecost() { return dc; }
-		virtual void pfcostdet(ostream&s) { 
+		virtual DlCost subtreecost(DlCost *dc) { return dc[idn]; }
+		virtual void pfcostdet(ostream&s, DlCost *dc) { 
 			s << OUT_LABEL ;
-			RNode::pfcostdet(s); 
+			RNode::pfcostdet(s,dc); 
 		}
 
 };
 
 class RTree;
+class TreeCode;
 
 #define F_INTERNAL 1
 #define F_LEAVES 2
@@ -165,18 +195,24 @@ class RTree
 {
 	protected:
 		RNode *rootn;
+		vector<RNode*> nodev; // nodes in pre-order, nodev[i]->id()==i
+		void number();
 		virtual RNode *parseNode(char *s, int &p);
+		RNode *decodeNode(TreeCode &c);
 		virtual RNode *createLeaf(const char *s, int len=0) { 
 			return new RLeaf(xstrndup(s,len)); 
 		} 
 		virtual RNode *createInt(RNode *a, RNode *b) { return new RInt(a,b); } 
 		virtual RNode *createInt(RNode *a, RNode *b, char* s, int len) { return new RInt(a,b,s,len); } 
 	public:
-		RTree(RNode *_root=NULL) : rootn(_root) { rootn->depth(0); }
+		RTree(RNode *_root=NULL) : rootn(_root) { rootn->depth(0); number(); }
 		RTree(char *fromstr);
-		virtual ~RTree() {}
+		RTree(TreeCode &c);
+		virtual ~RTree();
 		void str2tree(char *s) { int p=0; rootn=parseNode(s,p); }
 		RNode *root() { return rootn; } 
+		int size() { return nodev.size(); }
+		RNode *node(int i) { return nodev[i]; }
 		virtual ostream& print(ostream&s)  { return s << *rootn; }
 		friend ostream& operator<<(ostream&s, RTree &p)  { return p.print(s); }   
 };
@@ -188,19 +224,67 @@ class SpeciesTree : public RTree
 {
 	protected:
 		lab2leaves lmap;
+		// Euler tour LCA, built by preparelca()
+		vector<int> sizev, first, euler;
+		vector< vector<int> > sparse;
+		void tour(RNode *n);
 		void takeLeaves(RNode *r) { 
 			if (r->leaf()) lmap[((RLeaf*)r)->label()]=r; 
 			else { takeLeaves(((RInt*)r)->l()); takeLeaves(((RInt*)r)->r()); }    
 		}
 	public:
 		SpeciesTree(char *s) : RTree(s) { takeLeaves(rootn); }  
+		SpeciesTree(TreeCode &c) : RTree(c) { takeLeaves(rootn); }  
+		SpeciesTree(RNode *r) : RTree(r) { takeLeaves(rootn); }  
 		virtual ~SpeciesTree() {} 
-		RLeaf *getLeaf(char *s) {  return (RLeaf*)lmap[s]; }
+		RLeaf *getLeaf(char *s) {  
+			lab2leaves::iterator i = lmap.find(s); // no operator[]: must not insert, trees are shared between threads
+			return (i==lmap.end()) ? NULL : (RLeaf*)i->second; 
+		}
 		int lsize() { return lmap.size(); }
 		RNode *lca(RNode *a, RNode *b);    
-		void showcostdet(ostream&s) { rootn->showcostdet(s); } 
-		DlCost totalcost() { return rootn->subtreecost(); } 
-		void pfcostdet(ostream&s) { cout << "[ "; rootn->pfcostdet(s); cout << "]" << endl; }
+		void preparelca();
+		RNode *fastlca(RNode *a, RNode *b);
+		int isancestor(RNode *a, RNode *b) { return (a->id()<=b->id()) && (b->id()<a->id()+sizev[a->id()]); }
+		// dc: distribution array indexed by RNode::id()
+		void showcostdet(ostream&s, DlCost *dc) { rootn->showcostdet(s,dc); } 
+		DlCost totalcost(DlCost *dc) { return rootn->subtreecost(dc); } 
+		void pfcostdet(ostream&s, DlCost *dc) { cout << "[ "; rootn->pfcostdet(s,dc); cout << "]" << endl; }
+};
+
+// The tree induced in a species tree by a set of its leaves (-I): the
+// leaves and all their pairwise LCAs, with the unary nodes in between
+// suppressed. Its nodes keep the depths of the nodes they stand for, so
+// lossprim() counts the losses of the compressed paths and costs equal
+// those computed with the full tree. orig() maps a node back.
+
+class PInt : public RInt
+{
+	protected:
+		RNode *o;
+	public:
+		PInt(RNode *_l, RNode *_r, RNode *_o) : RInt(_l,_r), o(_o) {}
+		virtual void depth(int d) { RInt::depth(d); depthn=o->depth(); }
+		virtual RNode *orig() { return o; }
+};
+
+class PLeaf : public RLeaf
+{
+	protected:
+		RNode *o;
+	public:
+		PLeaf(RLeaf *_o) : RLeaf(_o), o(_o) {}
+		virtual void depth(int d) { depthn=o->depth(); }
+		virtual RNode *orig() { return o; }
+};
+
+class ProjectedTree : public SpeciesTree
+{
+	protected:
+		static RNode *project(SpeciesTree *full, vector<RNode*> &leaves);
+	public:
+		// leaves: leaves of full, which must have had preparelca() called
+		ProjectedTree(SpeciesTree *full, vector<RNode*> &leaves) : SpeciesTree(project(full,leaves)) {}
 };
 
 #endif
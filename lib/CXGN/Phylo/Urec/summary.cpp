@@ -0,0 +1,163 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+using namespace std;
+
+#include "summary.h"
+#include "options.h"
+
+void ckint(FILE *f, long v) { fwrite(&v,sizeof(v),1,f); }
+void ckdouble(FILE *f, double v) { fwrite(&v,sizeof(v),1,f); }
+
+static void ckread(FILE *f, void *v, size_t size)
+{
+    if (fread(v,size,1,f)==1) return;
+    cerr << "Truncated file" << endl;
+    exit(-1);
+}
+long ckgetint(FILE *f) { long v; ckread(f,&v,sizeof(v)); return v; }
+double ckgetdouble(FILE *f) { double v; ckread(f,&v,sizeof(v)); return v; }
+
+void SpeciesSummary::add(SpeciesSummary &s)
+{
+    votes+=s.votes;
+    total=total+s.total;
+    for (size_t k=0; k<wtotal.size(); k++)
+    {
+	wtotal[k]+=s.wtotal[k];
+	wdltotal[k].dup+=s.wdltotal[k].dup;
+	wdltotal[k].loss+=s.wdltotal[k].loss;
+	wdltotal[k].dc+=s.wdltotal[k].dc;
+    }
+    for (size_t i=0; i<dist.size(); i++) dist[i]=dist[i]+s.dist[i];
+}
+
+void savesummary(FILE *f, SpeciesSummary &s)
+{
+    ckdouble(f,s.votes);
+    ckint(f,s.total.dup); ckint(f,s.total.loss);
+    ckint(f,s.wtotal.size());
+    for (size_t k=0; k<s.wtotal.size(); k++)
+    {
+	ckdouble(f,s.wtotal[k]);
+	ckint(f,s.wdltotal[k].dup); ckint(f,s.wdltotal[k].loss); ckint(f,s.wdltotal[k].dc);
+    }
+    ckint(f,s.dist.size());
+    for (size_t i=0; i<s.dist.size(); i++) { ckint(f,s.dist[i].dup); ckint(f,s.dist[i].loss); }
+}
+
+void loadsummary(FILE *f, SpeciesSummary &s)
+{
+    s.votes=ckgetdouble(f);
+    s.total.dup=ckgetint(f); s.total.loss=ckgetint(f);
+    s.wtotal.resize(ckgetint(f));
+    s.wdltotal.resize(s.wtotal.size());
+    for (size_t k=0; k<s.wtotal.size(); k++)
+    {
+	s.wtotal[k]=ckgetdouble(f);
+	s.wdltotal[k].dup=ckgetint(f); s.wdltotal[k].loss=ckgetint(f); s.wdltotal[k].dc=ckgetint(f);
+    }
+    s.dist.resize(ckgetint(f));
+    for (size_t i=0; i<s.dist.size(); i++) { s.dist[i].dup=ckgetint(f); s.dist[i].loss=ckgetint(f); }
+}
+
+void printsummary(SpeciesTree *s, int genopt, int intweights, SpeciesSummary &sum)
+{
+    if (genopt & (OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL|OPT_SUMMARYDISTRIBUTIONS))
+	cout << *s << "\t";
+
+    if (sum.wtotal.size())
+    {
+	for (size_t k=0; k<sum.wtotal.size(); k++)
+	{
+	    if (genopt & OPT_SUMMARYTOTAL) cout << sum.wtotal[k] << "\t";
+	    if (genopt & OPT_SUMMARYDLTOTAL) cout << sum.wdltotal[k] << "\t";
+	}
+    }
+    else
+    {
+	if (genopt & OPT_SUMMARYTOTAL) 
+	{
+	    if (intweights) cout << IntWeights::mut(sum.total) << "\t";
+	    else cout << RealWeights::mut(sum.total) << "\t";
+	}
+	if (genopt & OPT_SUMMARYDLTOTAL) cout << sum.total << "\t";
+    }
+
+    if (genopt & (OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL|OPT_SUMMARYDISTRIBUTIONS))
+	cout << endl;
+	    
+    if (genopt & OPT_SUMMARYDISTRIBUTIONS) s->showcostdet(cout,&sum.dist[0]);
+    if (genopt & OPT_TREEDISTRIBUTIONS) s->pfcostdet(cout,&sum.dist[0]);
+}
+
+void shardrange(int i, int n, int gtrees, int &from, int &to)
+{
+    from=(long)gtrees*i/n;
+    to=(long)gtrees*(i+1)/n;
+}
+
+void saveshard(char *fn, ShardResults &r)
+{
+    FILE *f=fopen(fn,"wb");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    fwrite(SHARD_MAGIC,1,SHARD_MAGICLEN,f);
+    ckint(f,r.genopt); ckint(f,r.nweights); ckdouble(f,r.dupweight); ckdouble(f,r.lossweight);
+    ckint(f,r.shard); ckint(f,r.shards); ckint(f,r.gtrees); ckint(f,r.species.size());
+    for (size_t i=0; i<r.species.size(); i++)
+    {
+	ckint(f,r.species[i].size());
+	fwrite(r.species[i].data(),1,r.species[i].size(),f);
+	savesummary(f,r.sum[i]);
+    }
+    if (fclose(f))
+    {
+	cerr << "Cannot write file " << fn << endl;
+	exit(-1);
+    }
+}
+
+void loadshard(char *fn, ShardResults &r)
+{
+    char m[SHARD_MAGICLEN];
+    FILE *f=fopen(fn,"rb");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    if (fread(m,1,SHARD_MAGICLEN,f)!=SHARD_MAGICLEN || memcmp(m,SHARD_MAGIC,SHARD_MAGICLEN))
+    {
+	cerr << "Not a shard file: " << fn << endl;
+	exit(-1);
+    }
+    r.genopt=ckgetint(f); r.nweights=ckgetint(f); r.dupweight=ckgetdouble(f); r.lossweight=ckgetdouble(f);
+    r.shard=ckgetint(f); r.shards=ckgetint(f); r.gtrees=ckgetint(f);
+    if (r.shard<0 || r.shard>=r.shards)
+    {
+	cerr << "Bad shard " << r.shard << " of " << r.shards << " in " << fn << endl;
+	exit(-1);
+    }
+    r.species.resize(ckgetint(f));
+    r.sum.resize(r.species.size());
+    for (size_t i=0; i<r.species.size(); i++)
+    {
+	r.species[i].resize(ckgetint(f));
+	if (r.species[i].size()) ckread(f,&r.species[i][0],r.species[i].size());
+	loadsummary(f,r.sum[i]);
+    }
+    fclose(f);
+}
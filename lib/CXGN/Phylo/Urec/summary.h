@@ -0,0 +1,69 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _SUMMARY__
+#define _SUMMARY__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "rtree.h"
+#include "urtree.h"
+
+// fields of the binary files of -K and -J (native longs and doubles)
+void ckint(FILE *f, long v);
+void ckdouble(FILE *f, double v);
+long ckgetint(FILE *f);
+double ckgetdouble(FILE *f);
+
+// What -v and -b add up over the gene trees for one species tree
+typedef struct SpeciesSummary
+{
+    double votes;             // -v
+    DlCost total;             // -c, -C
+    vector<double> wtotal;    // -c, -C with -W, one per weight vector
+    vector<Rooting> wdltotal;
+    vector<DlCost> dist;      // -d, -x; by preorder index of the species tree
+    SpeciesSummary() : votes(0) {}
+    void add(SpeciesSummary &s);
+} SpeciesSummary;
+
+void savesummary(FILE *f, SpeciesSummary &s);
+void loadsummary(FILE *f, SpeciesSummary &s);
+
+// the lines of -c, -C, -d and -x for the species tree s
+void printsummary(SpeciesTree *s, int genopt, int intweights, SpeciesSummary &sum);
+
+// Shards (-J i/N,file). The gene trees are split by input index into N
+// runs of consecutive trees; shard i reconciles run i and, instead of the
+// summary output, writes the sums of its gene trees to file. urec-merge
+// adds the files of all N shards up and prints the summary output of a
+// run over all the gene trees.
+//
+//   "URECSH" 1, genopt, weight vectors, -D, -L, shard, shards, gene trees
+//   (all shards), species trees, then for every species tree its Newick
+//   string and SpeciesSummary
+#define SHARD_MAGIC "URECSH\1"
+#define SHARD_MAGICLEN 7
+
+typedef struct ShardResults
+{
+    int genopt, nweights, shard, shards, gtrees;
+    double dupweight, lossweight;
+    vector<string> species;
+    vector<SpeciesSummary> sum;
+} ShardResults;
+
+// the gene trees [from,to) of shard i of n
+void shardrange(int i, int n, int gtrees, int &from, int &to);
+void saveshard(char *fn, ShardResults &r);
+void loadshard(char *fn, ShardResults &r);
+
+#endif
@@ -7,28 +7,24 @@
    charged for it and provided that this copyright notice is not removed. 
 *************************************************************************/
 
-#include <set>
+#include <map>
+#include <sstream>
+#include <algorithm>
 using namespace std;
 #include <stdlib.h>
 #include <unistd.h>
+#include <time.h>
 #include "rtree.h"
 #include "urtree.h"
+#include "loader.h"
+#include "parallel.h"
+#include "bintree.h"
+#include "zstream.h"
+#include "distfile.h"
+#include "matrix.h"
+#include "options.h"
+#include "summary.h"
 
-#define OPT_RECDETAILS 1
-#define OPT_RECINFO 2
-#define OPT_PRINTROOTED 4 
-#define OPT_RECMINROOTING 8
-#define OPT_RECTREECOSTDETAILS 16
-#define OPT_PRINTGENE 32
-#define OPT_PRINTSPECIES 64
-#define OPT_RECMINCOST 128
-#define OPT_SUMMARYTOTAL 256
-#define OPT_SUMMARYDISTRIBUTIONS 512
-#define OPT_SUMMARYDLTOTAL (1<<12)
-#define OPT_TREEDISTRIBUTIONS (1<<13)
-#define OPT_VOTING (1<<14)
-#define OPT_BYCOST (1<<15)
-#define OPT_RANDUNIQUE (1<<16)
 
 int usage(int argc, char **argv)
 {
@@ -36,8 +32,44 @@ int usage(int argc, char **argv)
     cout << " Usage: " << argv[0] << " [options]"<< endl;
     cout << " -g gene tree "  << endl;
     cout << " -s species tree"  << endl;
-    cout << " -G filename - defines a set of gene trees"  << endl;
+    cout << " -G filename - defines a set of gene trees (- for standard input)"  << endl;
+    cout << "    gene trees may have polytomies, resolved for every species tree greedily (children merged"  << endl;
+    cout << "    by deepest lca first), which need not give the least cost over all resolutions"  << endl;
     cout << " -S filename - defines a set of species trees"  << endl;
+    cout << " -f filename - gene trees grouped in families, lines: family tree; for every species tree and family"  << endl;
+    cout << "    shows the support of the root bipartitions chosen by its trees: species, family, count, frequency,"  << endl;
+    cout << "    and the gene names of the side without the smallest one (co-optimal rootings share a vote)"  << endl;
+    cout << "    -G and -S also read the binary files of -T"  << endl;
+    cout << " -m filename - species name map of CXGN::Phylo::Species_name_map, (variant => standard, ...) or a pair"  << endl;
+    cout << "    per line; the species of the leaves of trees read after it are standardized (to_standard_format)"  << endl;
+    cout << "    and mapped, in gene and species trees alike"  << endl;
+    cout << " -T binfile - convert the next -G or -S file to binary binfile instead of reading it"  << endl;
+    cout << "    -G, -S and -T files may be gzip (or zstd) compressed"  << endl;
+    cout << " -w filename - write the output to filename, compressed if it ends with .gz or .zst"  << endl;
+    cout << " -K file[,seconds] - checkpoint the -b loop to file every 600 (or the given) seconds"  << endl;
+    cout << " -U - resume the run from the -K file; with -w the output is cut back to the checkpoint,"  << endl;
+    cout << "      else only the output after it is printed"  << endl;
+    cout << " -Y editfile - edit the gene tree, one edit per line, and show its optimal rooting edge(dup,loss)"  << endl;
+    cout << "    with the first species tree before and after every edit; edges are numbered as in -k"  << endl;
+    cout << "    and v of -F, new ones from the number of nodes of the input tree on:"  << endl;
+    cout << "      nni e f - swap the subtrees at the edges e and f, which meet an internal edge at its two ends"  << endl;
+    cout << "      spr e f - move the subtree at the edge e onto the edge f"  << endl;
+    cout << "      ins e label - insert a leaf in the middle of the edge e"  << endl;
+    cout << "      del e - delete the leaf of the edge e"  << endl;
+    cout << " -M filename - write the dup and loss of the optimal rootings of all pairs of trees as a binary"  << endl;
+    cout << "    matrix for mapping: a 16-byte header, then int32 dup,loss rows of gene trees by species trees"  << endl;
+    cout << "    in input order (see matrix.h)"  << endl;
+    cout << " -N num[,seed] - null model: reconcile num random trees over the leaves of every gene tree, in memory;"  << endl;
+    cout << "    shows species, gene, cost, p-value (the share of random trees as cheap or cheaper, with +1),"  << endl;
+    cout << "    and the mean and variance of the random costs; the seed (default: the time) is shown on stderr"  << endl;
+    cout << " -J i/N,file - shard i of N (from 0): only the i-th of N equal runs of consecutive gene trees;"  << endl;
+    cout << "    the sums of -v, -c, -C, -d and -x go to file instead, for urec-merge, and -F counts"  << endl;
+    cout << "    the gene trees of the whole input"  << endl;
+    cout << " -y filename - stream species trees (- for standard input, one per line) instead of -s and -S:"  << endl;
+    cout << "    they are reconciled and freed a block at a time, with the gene trees hash-consed as in -H"  << endl;
+    cout << "    (unless -I); -o, -F, -c and -C show what they do with -b. From a file the results come"  << endl;
+    cout << "    256 species trees at a time, from a pipe or terminal as soon as each tree's line is read"  << endl;
+    cout << " -j num - number of threads (default: one per cpu)"  << endl;
     cout << " -R - show rootings for every gene tree"  << endl;
     cout << " -p - print a gene tree"  << endl;
     cout << " -P - print a species tree"  << endl;
@@ -51,9 +83,26 @@ int usage(int argc, char **argv)
     cout << "   -u - unique leaves (a species tree)" << endl;
     cout << "   -E num - number of leaves" << endl;
     cout << " -b - computing costs"  << endl;
+    cout << " -H - share mappings and costs of identical gene subtrees (hash-consing)"  << endl;
+    cout << " -I - reconcile with the species subtree induced by the gene tree's species"  << endl;
+    cout << " -t - leave out the gene leaves whose species are not in the species tree, for each species tree;"  << endl;
+    cout << "    their number goes to stderr"  << endl;
+    cout << " -W d,l[,c]:d,l[,c]:... - weight vectors of duplications, losses and deep coalescence;"  << endl;
+    cout << "    -o, -O, -F, -c and -C report the optimum under each of them (one mapping per pair of trees,"  << endl;
+    cout << "    so polytomies are resolved once, with the weights of -D and -L)"  << endl;
     cout << " For every reconciliation of an unrooted gene tree with a species tree (details of costs):" << endl;
     cout << "   -o - show an optimal cost"  << endl;
     cout << "   -O - show an optimal rooting"  << endl;
+    cout << "   -k num - show the num cheapest rootings, 0 - all optimal ones: edge(dup,loss) ..."  << endl;
+    cout << "      an edge is the preorder index of its lower node in the input tree"  << endl;
+    cout << "   -F tsv|json - show an optimal rooting as a record: species, gene, weights, u, v, dup, loss" << endl;
+    cout << "      species and gene count the trees from 0, weights the -W vectors (0 without -W);"  << endl;
+    cout << "      u and v are the ends of the edge in input preorder, v its lower node as in -k" << endl;
+    cout << "   -V - show the events of an optimal rooting, a record per node (tsv, or json with -F json):" << endl;
+    cout << "      species, gene, weights, node, mapping, dup; node in input preorder, -1 for the root," << endl;
+    cout << "      -2 for a node added to resolve a polytomy (the polytomy's index is on its top node)," << endl;
+    cout << "      mapping the species node in preorder (-1 for none, -t), dup 1 for a duplication;" << endl;
+    cout << "      not with -F tsv, -F json tells the records apart" << endl;
     cout << "   -a - show attributes and mappings" << endl;
     cout << "   -A - show detailed attributes"<< endl;
     cout << " For every species tree, i.e., summary of costs when reconciling a species tree with a set of gene trees):" << endl; 
@@ -61,47 +110,540 @@ int usage(int argc, char **argv)
     cout << "   -C - print total dl-cost (dup,loss)"  << endl;
     cout << "   -d - print detailed total cost (distributions)" << endl;
     cout << "   -x - print species tree with detailed total costs (nested parenthesis notation with attributes)" << endl;
+    cout << "   -Z filename - write the distributions of -d to filename, only nonzero nodes by preorder index;" << endl;
+    cout << "      binary, or text if the name ends with .tsv (before .gz or .zst); urecdist prints them" << endl;
 
     exit(-1);
 }
 
 #define BUFSIZE 10000    
-void readgtree(char *fn, set<UTree*> &gtset)
+void readstree(char *fn,vector<SpeciesTree*> &stset)
 {
     FILE *f;
-    f= fopen(fn,"r");
+    f= zopen(fn,"r");
     if (!f)
     {
 	cerr << "Cannot open file " << fn << endl;
 	exit(-1);
     }
-    while (1)
+    if (isbinary(f))
+    {
+	vector<SpeciesTree*> v;
+	readstree_bin(f,fn,v);
+	stset.insert(stset.end(),v.begin(),v.end());
+	return;
+    }
+    char *buf=NULL;
+    size_t len=0;
+    while (getline(&buf,&len,f)>=0)
     {
-	char buf[BUFSIZE];
-	if (!fgets(buf,BUFSIZE,f)) break;
-	gtset.insert(new UTree(buf));	    
+	if (strspn(buf," \t\r\n")==strlen(buf)) continue;
+	stset.push_back(new SpeciesTree(buf));	    
     }
+    free(buf);
     fclose(f);
 }
 
-void readstree(char *fn,set<SpeciesTree*> &stset)
+
+// -W: d,l[,c] vectors separated by ':'
+void readweights(char *s, vector<Weights> &wv)
 {
-    FILE *f;
-    f= fopen(fn,"r");
+    for (char *t=strtok(s,":"); t; t=strtok(NULL,":"))
+    {
+	Weights w;
+	w.dc=0;
+	if (sscanf(t,"%lf,%lf,%lf",&w.dup,&w.loss,&w.dc)<2)
+	{
+	    cerr << "Weight vector d,l[,c] expected in -W" << endl;
+	    exit(-1);
+	}
+	wv.push_back(w);
+    }
+}
+
+// -F: one optimal rooting of gene tree gi with species tree si
+void printedge(int fmt, int si, int gi, int wi, PairCost &p)
+{
+    if (fmt==FMT_TSV)
+	cout << si << "\t" << gi << "\t" << wi << "\t" << p.a << "\t" << p.v << "\t" << p.cost.dup << "\t" << p.cost.loss << endl;
+    else
+	cout << "{\"species\":" << si << ",\"gene\":" << gi << ",\"weights\":" << wi 
+	     << ",\"u\":" << p.a << ",\"v\":" << p.v << ",\"dup\":" << p.cost.dup << ",\"loss\":" << p.cost.loss << "}" << endl;
+}
+
+// -V: the node of gene tree gi at input preorder index pre (-1 for the
+// root, -2 for one added to resolve a polytomy) maps to species node m
+// (preorder index, -1 if none) in the rooting wi
+static void printevent(int fmt, int si, int gi, int wi, int pre, RNode *m, int dup)
+{
+    if (fmt==FMT_JSON)
+	cout << "{\"species\":" << si << ",\"gene\":" << gi << ",\"weights\":" << wi
+	     << ",\"node\":" << pre << ",\"mapping\":" << (m ? m->orig()->id() : -1) << ",\"dup\":" << dup << "}" << endl;
+    else
+	cout << si << "\t" << gi << "\t" << wi << "\t" << pre << "\t" << (m ? m->orig()->id() : -1) << "\t" << dup << endl;
+}
+
+// -V: the events of the tree rooted on the edge of un, one pass top-down.
+// The nodes of a resolved polytomy share its preorder index; the first one
+// reached keeps it, the others are added.
+void printevents(int fmt, int si, int gi, int wi, UTree *g, UNode *un, ReconcileContext &rc)
+{
+    vector<char> seen(g->size());
+    nodset todo(1,un);
+    if (un->p(rc))
+    {
+	// -t may leave one side without species
+	RNode *m1=un->M(rc), *m2=un->p(rc)->M(rc), *m = !m1 ? m2 : !m2 ? m1 : rc.st->lca(m1,m2);
+	printevent(fmt,si,gi,wi,-1,m,m1 && m2 && dupprim(m,m1,m2));
+	todo.push_back(un->p(rc));
+    }
+    while (todo.size())
+    {
+	UNode *x=todo.back();
+	todo.pop_back();
+	if (x->leaf())
+	{
+	    printevent(fmt,si,gi,wi,g->vertexpre(x,rc),x->M(rc),0);
+	    continue;
+	}
+	UNode *a=((UNode3*)x)->l()->p(rc), *b=((UNode3*)x)->r()->p(rc);
+	RNode *m=x->M(rc), *m1=a->M(rc), *m2=b->M(rc);
+	int pre=g->vertexpre(x,rc);
+	if (pre>=0 && seen[pre]++) pre=-2;
+	// a side without species (-t) makes no duplication
+	printevent(fmt,si,gi,wi,pre,m,m1 && m2 && dupprim(m,m1,m2));
+	todo.push_back(b);
+	todo.push_back(a);
+    }
+}
+
+// -K: the state of the -b loop before gene tree gi of species tree si,
+// with the run it belongs to (the same options and trees)
+#define CK_MAGIC "URECCK\3"
+#define CK_MAGICLEN 7
+
+typedef struct Checkpoint
+{
+    int genopt, format, topk, nweights, gtrees, strees;
+    unsigned long sthash;  // of the species trees in loop order
+    unsigned long gthash;  // of the gene trees
+    int si, gi;
+    long outpos;           // size of the -w file, -1 without -w
+    long distpos;          // size of the -Z file, -1 without -Z
+    SpeciesSummary sum;    // of the gene trees before gi
+} Checkpoint;
+
+static unsigned long fnv(unsigned long h, const char *s, size_t len)
+{
+    for (size_t j=0; j<len; j++) h=(h^(unsigned char)s[j])*1099511628211UL;
+    return h;
+}
+
+unsigned long speciestreehash(vector<SpeciesTree*> &stset)
+{
+    unsigned long h=14695981039346656037UL;
+    for (vector<SpeciesTree*>::iterator i=stset.begin(); i!=stset.end(); ++i)
+    {
+	ostringstream o;
+	(*i)->print(o);
+	string s=o.str();
+	h=fnv(h,s.c_str(),s.size()+1);
+    }
+    return h;
+}
+
+// the edges (by node id) and the leaf labels of every gene tree
+unsigned long genetreehash(utreevec &gtset)
+{
+    unsigned long h=14695981039346656037UL;
+    for (utreevec::iterator i=gtset.begin(); i!=gtset.end(); ++i)
+    {
+	for (int j=0; j<(*i)->size(); j++)
+	{
+	    UNode *u=(*i)->node(j);
+	    int e[2]={ u->p() ? u->p()->id() : -1, u->eid() };
+	    h=fnv(h,(const char*)e,sizeof(e));
+	    if (u->leaf()) h=fnv(h,((ULeaf*)u)->complete(),strlen(((ULeaf*)u)->complete())+1);
+	}
+	h=fnv(h,"",1);
+    }
+    return h;
+}
+
+// written to fn.tmp and renamed, so fn is always a whole checkpoint
+void savecheckpoint(char *fn, Checkpoint &c)
+{
+    string tmp=string(fn)+".tmp";
+    FILE *f=fopen(tmp.c_str(),"wb");
+    if (!f)
+    {
+	cerr << "Cannot open file " << tmp << endl;
+	exit(-1);
+    }
+    fwrite(CK_MAGIC,1,CK_MAGICLEN,f);
+    ckint(f,c.genopt); ckint(f,c.format); ckint(f,c.topk); ckint(f,c.nweights);
+    ckint(f,c.gtrees); ckint(f,c.strees); ckint(f,c.sthash); ckint(f,c.gthash);
+    ckint(f,c.si); ckint(f,c.gi); ckint(f,c.outpos); ckint(f,c.distpos);
+    savesummary(f,c.sum);
+    if (fclose(f) || rename(tmp.c_str(),fn))
+    {
+	cerr << "Cannot write checkpoint " << fn << endl;
+	exit(-1);
+    }
+}
+
+void loadcheckpoint(char *fn, Checkpoint &c)
+{
+    char m[CK_MAGICLEN];
+    FILE *f=fopen(fn,"rb");
+    if (!f)
+    {
+	cerr << "Cannot open checkpoint " << fn << endl;
+	exit(-1);
+    }
+    if (fread(m,1,CK_MAGICLEN,f)!=CK_MAGICLEN || memcmp(m,CK_MAGIC,CK_MAGICLEN))
+    {
+	cerr << "Not a checkpoint file: " << fn << endl;
+	exit(-1);
+    }
+    c.genopt=ckgetint(f); c.format=ckgetint(f); c.topk=ckgetint(f); c.nweights=ckgetint(f);
+    c.gtrees=ckgetint(f); c.strees=ckgetint(f); c.sthash=ckgetint(f); c.gthash=ckgetint(f);
+    c.si=ckgetint(f); c.gi=ckgetint(f); c.outpos=ckgetint(f); c.distpos=ckgetint(f);
+    loadsummary(f,c.sum);
+    fclose(f);
+}
+
+// trees per PairCosts with n trees of the other kind, for at most about
+// 64 MB of results
+static int pairsblock(size_t n)
+{
+    return (64<<20)/(sizeof(PairCost)*n+1)+1;
+}
+
+// -M: all the pairs, computed in parallel block by block of gene trees;
+// the rows of a block are written as soon as it is done
+void writematrix(char *fn, utreevec &gtset, vector<SpeciesTree*> &stset, CladeTable *clades, int project)
+{
+    MatrixHeader h;
+    memcpy(h.magic,MATRIX_MAGIC,MATRIX_MAGICLEN);
+    h.genes=gtset.size();
+    h.species=stset.size();
+    FILE *f=zopen(fn,"w");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    int ok=fwrite(&h,sizeof(h),1,f)==1;
+    size_t block=pairsblock(stset.size());
+    for (size_t from=0; ok && from<gtset.size(); from+=block)
+    {
+	size_t to=min(from+block,gtset.size());
+	utreevec gt(gtset.begin()+from,gtset.begin()+to);
+	PairCosts pc(gt,stset,clades,project);
+	pc.run();
+	vector<int32_t> m((to-from)*h.species*2);
+	for (size_t g=0; g<gt.size(); g++)
+	    for (size_t s=0; s<stset.size(); s++)
+	    {
+		DlCost &c=pc.at(g,s).cost;
+		m[(g*h.species+s)*2]=c.dup;
+		m[(g*h.species+s)*2+1]=c.loss;
+	    }
+	ok=!m.size() || fwrite(&m[0],sizeof(int32_t),m.size(),f)==m.size();
+    }
+    if (fclose(f) || !ok)
+    {
+	cerr << "Cannot write file " << fn << endl;
+	exit(-1);
+    }
+}
+
+// -y: species trees read a block at a time, each block reconciled with all
+// gene trees at once (PairCosts) and freed before the next is read, so
+// the number of species trees does not matter. Small blocks keep a slow
+// stream going, and from a pipe or terminal a block is one tree, answered
+// as soon as its line is in; the summaries are those of the -b fast path.
+#define STREAM_BLOCK 256
+void streamspecies(char *fn, utreevec &gtset, CladeTable *clades, int genopt, int format, int intweights)
+{
+    FILE *f = zopen(fn,"r");
     if (!f)
     {
 	cerr << "Cannot open file " << fn << endl;
 	exit(-1);
     }
+    size_t block=zstreaming(fn) ? 1 : min(pairsblock(gtset.size()),STREAM_BLOCK);
+    // and each species tree has a CladeMemo
+    if (clades) block=min(block,(size_t)(64<<20)/(clades->size()*(sizeof(RNode*)+sizeof(DlCost))+1)+1);
+    char *buf=NULL;
+    size_t len=0;
+    int si=0;
     while (1)
     {
-	char buf[BUFSIZE];
-	if (!fgets(buf,BUFSIZE,f)) break;
-	stset.insert(new SpeciesTree(buf));	    
+	vector<SpeciesTree*> st;
+	while (st.size()<block && getline(&buf,&len,f)>=0)
+	{
+	    if (strspn(buf," \t\r\n")==strlen(buf)) continue;
+	    st.push_back(new SpeciesTree(buf));
+	    if (genopt & OPT_PROJECT) st.back()->preparelca();
+	}
+	if (st.empty()) break;
+	PairCosts pairs(gtset,st,clades,genopt & OPT_PROJECT);
+	pairs.run();
+	for (size_t s=0; s<st.size(); s++, si++)
+	{
+	    SpeciesSummary sum;
+	    for (size_t g=0; g<gtset.size(); g++)
+	    {
+		PairCost &p=pairs.at(g,s);
+		if (format) printedge(format,si,g,0,p);
+		if (genopt & OPT_RECMINCOST) cout << p.cost << endl;
+		sum.total.dup+=p.cost.dup;
+		sum.total.loss+=p.cost.loss;
+	    }
+	    printsummary(st[s],genopt,intweights,sum);
+	    delete st[s];
+	}
     }
+    free(buf);
     fclose(f);
 }
 
+// -N: the cost of every gene tree against those of random trees over its
+// leaves. The random trees are only built in memory and reconciled. Each
+// gene tree draws from its own rand_r() state, seeded by the run seed and
+// its input index, so the results do not depend on the threads.
+template<class W> struct NullModel
+{
+    utreevec &gt;
+    SpeciesTree *s;
+    int samples, project, gfirst;
+    unsigned int seed;
+    vector<string> out;
+    NullModel(utreevec &g, SpeciesTree *s_, int n, int pr, int gf, unsigned int sd) :
+	gt(g), s(s_), samples(n), project(pr), gfirst(gf), seed(sd), out(g.size()) {}
+    typename W::value cost(UTree *g, SpeciesTree *sp)
+    {
+	ReconcileContext rc(g,sp);
+	return W::mut(g->findoptimaledge(rc)->cost(rc));
+    }
+    void operator()(int i, int tid)
+    {
+	UTree *g=gt[i];
+	SpeciesTree *sp = project ? projection(s,g) : s;
+	unsigned int state=seed^(2654435761U*(gfirst+i+1));
+	double c=cost(g,sp), sum=0, sum2=0;
+	int le=0;
+	for (int k=0; k<samples; k++)
+	{
+	    UTree r(g,&state);
+	    double x=cost(&r,sp);
+	    if (x<=c) le++;
+	    sum+=x;
+	    sum2+=x*x;
+	}
+	if (sp!=s) delete sp;
+	double mean=sum/samples;
+	double var = samples>1 ? (sum2-sum*mean)/(samples-1) : 0;
+	ostringstream o;
+	o << c << "\t" << (le+1.0)/(samples+1) << "\t" << mean << "\t" << var;
+	out[i]=o.str();
+    }
+};
+
+template<class W> void nullmodel(utreevec &gtset, vector<SpeciesTree*> &stset, int samples, unsigned int seed, int project, int gfirst)
+{
+    for (size_t si=0; si<stset.size(); si++)
+    {
+	NullModel<W> n(gtset,stset[si],samples,project,gfirst,seed);
+	parallel_for(gtset.size(),n);
+	for (size_t i=0; i<gtset.size(); i++) cout << si << "\t" << gfirst+i << "\t" << n.out[i] << endl;
+    }
+}
+
+// -v: every gene tree votes for the species trees of minimal cost
+template<class W> void voting(utreevec &gtset, vector<SpeciesTree*> &stset, CladeTable *clades, int project, vector<double> &mincnts)
+{
+    int trnum = stset.size();
+    int i;
+
+    mincnts.assign(trnum,0);
+
+    // the reconciliations share the trees, so all pairs can be done at once
+    PairCosts pc(gtset,stset,clades,project);
+    pc.run();
+
+    vector<typename W::value> m(trnum);
+    for (size_t j=0; j<gtset.size(); j++)
+    {
+	for (i=0; i<trnum; i++) m[i]=W::mut(pc.at(j,i).cost);
+	typename W::value min=0;
+	int minc=0;
+	for (i=0; i<trnum; i++)
+	{
+	    if (i==0) { min=m[i]; minc=1; }
+	    else 
+		if (min>m[i]) { min=m[i]; minc=1; }
+		else if (min==m[i]) minc++;
+	}
+	for (i=0; i<trnum; i++)
+	    if (m[i]==min)
+		mincnts[i]+=1.0/minc;
+    }
+}
+
+// -f: the replicates (e.g. bootstrap trees) of one gene family
+struct Family
+{
+    string name;
+    vector<int> trees; // indices in gtset
+    CladeTable *clades;
+};
+
+// a root bipartition: the sorted gene names of one side of the edge of u,
+// the side without the smallest name
+static string bipartition(UNode *u, ReconcileContext &rc)
+{
+    vector<string> side[2];
+    nodset v[2];
+    u->insert(&v[0],&rc);
+    if (u->p(rc)) u->p(rc)->insert(&v[1],&rc);
+    for (int k=0; k<2; k++)
+    {
+	for (size_t i=0; i<v[k].size(); i++)
+	    if (v[k][i]->leaf()) side[k].push_back(((ULeaf*)v[k][i])->geneid());
+	sort(side[k].begin(),side[k].end());
+    }
+    int k = side[0].size() && (side[1].empty() || side[0][0]<side[1][0]);
+    string s;
+    for (size_t i=0; i<side[k].size(); i++) s+=(i ? "," : "")+side[k][i];
+    return s;
+}
+
+// Every replicate votes for the bipartitions of its optimal rootings, ties
+// sharing the vote. The replicates of a family have mostly the same
+// clades, so their mappings and subtree costs are computed once, in a
+// CladeMemo of the family (or, with -H, of all the gene trees).
+template<class W> struct RootSupport
+{
+    utreevec &gt;
+    vector<Family> &fam;
+    SpeciesTree *s;
+    CladeMemo *memo;
+    int si;
+    vector<string> out;
+    RootSupport(utreevec &g, vector<Family> &f, SpeciesTree *s_, CladeMemo *m, int i) : 
+	gt(g), fam(f), s(s_), memo(m), si(i), out(f.size()) {}
+    void operator()(int f, int tid)
+    {
+	Family &F=fam[f];
+	CladeMemo *m = memo ? memo : new CladeMemo(*F.clades,s);
+	map<string,double> support;
+	for (size_t i=0; i<F.trees.size(); i++)
+	{
+	    UTree *g=gt[F.trees[i]];
+	    ReconcileContext rc(g,s);
+	    rc.usememo(m);
+	    nodset r;
+	    g->rootings<W>(rc,0,r);
+	    for (size_t j=0; j<r.size(); j++) support[bipartition(r[j],rc)]+=1.0/r.size();
+	}
+	if (!memo) delete m;
+	vector<pair<double,string> > v;
+	for (map<string,double>::iterator i=support.begin(); i!=support.end(); ++i)
+	    v.push_back(make_pair(-i->second,i->first));
+	sort(v.begin(),v.end());
+	ostringstream o;
+	for (size_t i=0; i<v.size(); i++)
+	    o << si << "\t" << F.name << "\t" << -v[i].first << "\t" << -v[i].first/F.trees.size() << "\t" << v[i].second << endl;
+	out[f]=o.str();
+    }
+};
+
+template<class W> void rootsupport(utreevec &gtset, vector<Family> &fam, vector<SpeciesTree*> &stset, CladeTable *clades)
+{
+    int si=0;
+    for (vector<SpeciesTree*>::iterator stpos=stset.begin(); stpos !=stset.end(); ++stpos, ++si)
+    {
+	CladeMemo *memo = clades ? new CladeMemo(*clades,*stpos) : NULL;
+	RootSupport<W> r(gtset,fam,*stpos,memo,si);
+	parallel_for(fam.size(),r);
+	for (size_t i=0; i<fam.size(); i++) cout << r.out[i];
+	delete memo;
+    }
+}
+
+// the directed nodes of the edge e, as edgeid() (-k, -F) names it: two,
+// more inside a resolved polytomy, none if it is not in the tree. -Y
+// takes out no leaves (-t), so both ends of an edge have its eid().
+static nodset edgenodes(UTree *g, int e)
+{
+    nodset v;
+    for (int i=0; i<g->size(); i++)
+	if (g->node(i)->eid()==e) v.push_back(g->node(i));
+    return v;
+}
+
+// -Y: edits of one gene tree, reconciled with one species tree after each
+void editscript(char *fn, UTree *g, SpeciesTree *s)
+{
+    FILE *f = zopen(fn,"r");
+    if (!f)
+    {
+	cerr << "Cannot open file " << fn << endl;
+	exit(-1);
+    }
+    ReconcileContext rc(g,s);
+    g->adopt(&rc); // the edits name the edges of the resolved tree
+    UNode *opt=g->findoptimaledge(rc);
+    cout << g->edgeid(opt,rc) << opt->cost(rc) << endl;
+    char buf[BUFSIZE];
+    while (fgets(buf,BUFSIZE,f))
+    {
+	char op[10], lab[BUFSIZE];
+	int a, b, done=0;
+	if (sscanf(buf,"%9s",op)!=1) continue;
+	if (!strcmp(op,"nni") && sscanf(buf,"%*s %d %d",&a,&b)==2)
+	{
+	    nodset x=edgenodes(g,a), y=edgenodes(g,b);
+	    for (size_t i=0; i<x.size() && !done; i++)
+		for (size_t j=0; j<y.size() && !done; j++)
+		    done=g->nni(x[i],y[j],&rc);
+	}
+	else if (!strcmp(op,"spr") && sscanf(buf,"%*s %d %d",&a,&b)==2)
+	{
+	    // one side of a can go onto b, the one without b
+	    nodset x=edgenodes(g,a), y=edgenodes(g,b);
+	    for (size_t i=0; i<x.size() && !done && y.size(); i++)
+		done=g->spr(x[i],y[0],&rc);
+	}
+	else if (!strcmp(op,"ins") && sscanf(buf,"%*s %d %s",&a,lab)==2)
+	{
+	    nodset x=edgenodes(g,a);
+	    done=x.size() && g->insertleaf(lab,x[0],&rc);
+	}
+	else if (!strcmp(op,"del") && sscanf(buf,"%*s %d",&a)==1)
+	{
+	    nodset x=edgenodes(g,a);
+	    for (size_t i=0; i<x.size() && !done; i++)
+		done=g->deleteleaf(x[i],&rc);
+	}
+	else
+	{
+	    cerr << "Unknown edit: " << buf;
+	    exit(-1);
+	}
+	if (!done)
+	{
+	    cerr << "Edit not possible: " << buf;
+	    exit(-1);
+	}
+	opt=g->findoptimaledge(rc);
+	cout << g->edgeid(opt,rc) << opt->cost(rc) << endl;
+    }
+    fclose(f);
+}
 
 int  main(int argc, char **argv)
 {
@@ -113,26 +655,125 @@ int  main(int argc, char **argv)
     double rt_dec=0.75;
 
     if (argc<2) usage(argc,argv);
-    set<SpeciesTree*> stset;
-    set<UTree*> gtset;
+    vector<SpeciesTree*> stset;
+    utreevec gtset;
 
     srand (time (0));
 
     int genopt=0;
-    while ((opt = getopt (argc, argv, "bvg:s:pPE:uaAr:Rl:i:e:n:OoG:XcCdxL:D:S:")) != -1)
+    vector<Weights> weights;
+    int topk=-1;
+    char *binfile=NULL;
+    int format=0;
+    FILE *out=NULL;
+    char *outname=NULL;
+    streambuf *coutbuf=cout.rdbuf();
+    char *ckfile=NULL;
+    int ckinterval=600;
+    int resume=0;
+    char *editfile=NULL;
+    char *distname=NULL;
+    char *matrixname=NULL;
+    char *streamname=NULL;
+    char *shardfile=NULL;
+    int shard=0, shards=1, gfirst=0; // gfirst: the input index of gtset[0]
+    ShardResults part;
+    int nullsamples=0;
+    unsigned int nullseed=time(0);
+    DistWriter *distout=NULL;
+    vector<string> famof; // -f: the family of every tree of famtree
+    vector<int> famtree;
+    while ((opt = getopt (argc, argv, "bvg:s:pPE:uaAr:Rl:i:e:n:OoG:XcCdxL:D:S:j:HIW:k:T:F:w:K:UY:f:Z:M:J:N:m:Vty:")) != -1)
 	switch (opt)
 	{
 	    case 'g':
-		gtset.insert(new UTree(optarg));
+		gtset.push_back(new UTree(optarg));
 		break;
 	    case 's':
-		stset.insert(new SpeciesTree(optarg));
+		stset.push_back(new SpeciesTree(optarg));
 		break;
 	    case 'S':
-		readstree(optarg,stset);
-		break;
 	    case 'G':
-		readgtree(optarg,gtset);
+		if (binfile)
+		{
+		    cerr << newick2bin(optarg,binfile) << " trees written to " << binfile << endl;
+		    binfile=NULL;
+		}
+		else if (opt=='S') readstree(optarg,stset);
+		else readgtree(optarg,gtset);
+		break;
+	    case 'T':
+		binfile=optarg;
+		break;
+	    case 'w':
+		outname=optarg;
+		break;
+	    case 'K':
+		ckfile=strtok(optarg,",");
+		if ((optarg=strtok(NULL,",")) && sscanf(optarg,"%d",&ckinterval)!=1) 
+		{
+		    cerr << "Number of seconds expected in -K" << endl;
+		    exit(-1);
+		}
+		break;
+	    case 'U':
+		resume=1;
+		break;
+	    case 'Y':
+		editfile=optarg;
+		break;
+	    case 'M':
+		matrixname=optarg;
+		break;
+	    case 'y':
+		streamname=optarg;
+		break;
+	    case 'm':
+		loadspeciesmap(optarg);
+		break;
+	    case 'N':
+		if (sscanf(optarg,"%d",&nullsamples)!=1 || nullsamples<1 ||
+		    (strchr(optarg,',') && sscanf(strchr(optarg,',')+1,"%u",&nullseed)!=1))
+		{
+		    cerr << "num[,seed] expected in -N" << endl;
+		    exit(-1);
+		}
+		break;
+	    case 'J':
+		if (sscanf(optarg,"%d/%d",&shard,&shards)!=2 || shard<0 || shard>=shards || 
+		    !strchr(optarg,',') || !*(shardfile=strchr(optarg,',')+1))
+		{
+		    cerr << "i/N,file expected in -J" << endl;
+		    exit(-1);
+		}
+		break;
+	    case 'Z':
+		distname=optarg;
+		genopt|=OPT_DISTFILE;
+		break;
+	    case 'f':
+	    {
+		size_t n=gtset.size();
+		readfamilies(optarg,gtset,famof);
+		for (; n<gtset.size(); n++) famtree.push_back(n);
+		break;
+	    }
+	    case 'F':
+		if (!strcmp(optarg,"tsv")) format=FMT_TSV;
+		else if (!strcmp(optarg,"json")) format=FMT_JSON;
+		else
+		{
+		    cerr << "tsv or json expected in -F" << endl;
+		    exit(-1);
+		}
+		genopt|=OPT_BYCOST;
+		break;
+	    case 'j':
+		if (sscanf(optarg,"%d",&num_threads)!=1) 
+		{
+		    cerr << "Number expected in -j" << endl;
+		    exit(-1);
+		}
 		break;
 	    case 'p':
 		genopt|=OPT_PRINTGENE;
@@ -152,7 +793,7 @@ int  main(int argc, char **argv)
 		break;
 	    case 'r':
 		for (int i=0; i<loop; i++)
-		    gtset.insert(new UTree(rt_len,rt_pint,rt_dec,rt_numlv,(genopt&OPT_RANDUNIQUE), optarg));	 
+		    gtset.push_back(new UTree(rt_len,rt_pint,rt_dec,rt_numlv,(genopt&OPT_RANDUNIQUE), optarg));	 
 		break;
 	    case 'n':
 		if (sscanf(optarg,"%d",&rt_len)!=1) 
@@ -189,6 +830,28 @@ int  main(int argc, char **argv)
 	case 'b':
 		genopt|=OPT_BYCOST;
 		break;
+	    case 'H':
+		genopt|=OPT_HASHCONS;
+		break;
+	    case 'I':
+		genopt|=OPT_PROJECT;
+		break;
+	    case 't':
+		prune_absent=1;
+		break;
+	    case 'W':
+		readweights(optarg,weights);
+		break;
+	    case 'k':
+		if (sscanf(optarg,"%d",&topk)!=1 || topk<0) 
+		{
+		    cerr << "Number expected in -k" << endl;
+		    exit(-1);
+		}
+		break;
+	    case 'V':
+		genopt|=OPT_EVENTS;
+		break;
 	    case 'a':
 		genopt|=OPT_RECINFO;
 		break;
@@ -247,86 +910,259 @@ int  main(int argc, char **argv)
 		exit(-1);
 	}
 
-    set<SpeciesTree*>::iterator stpos;
-    set<UTree*>::iterator gtpos;
+    vector<SpeciesTree*>::iterator stpos;
+    utreevec::iterator gtpos;
+
+    if ((genopt & OPT_EVENTS) && format==FMT_TSV)
+    {
+	cerr << "-V and -F tsv cannot be combined, their rows would be mixed; use -F json" << endl;
+	exit(-1);
+    }
+
+    if (shardfile)
+    {
+	if (resume || famtree.size())
+	{
+	    cerr << "-J cannot be combined with -U or -f" << endl;
+	    exit(-1);
+	}
+	int to;
+	shardrange(shard,shards,gtset.size(),gfirst,to);
+	part.genopt=genopt;
+	part.nweights=weights.size();
+	part.dupweight=weight_dup;
+	part.lossweight=weight_loss;
+	part.shard=shard;
+	part.shards=shards;
+	part.gtrees=gtset.size();
+	for (size_t i=0; i<stset.size(); i++)
+	{
+	    ostringstream o;
+	    stset[i]->print(o);
+	    part.species.push_back(o.str());
+	}
+	part.sum.resize(stset.size());
+	for (size_t i=0; i<gtset.size(); i++)
+	    if ((int)i<gfirst || (int)i>=to) delete gtset[i];
+	gtset.erase(gtset.begin()+to,gtset.end());
+	gtset.erase(gtset.begin(),gtset.begin()+gfirst);
+    }
+
+    Checkpoint ck;
+    ck.genopt=genopt;
+    ck.format=format;
+    ck.topk=topk;
+    ck.nweights=weights.size();
+    ck.gtrees=gtset.size();
+    ck.strees=stset.size();
+    ck.sthash=ckfile ? speciestreehash(stset) : 0;
+    ck.gthash=ckfile ? genetreehash(gtset) : 0;
+    if (resume)
+    {
+	if (!ckfile)
+	{
+	    cerr << "-U needs the checkpoint file of -K" << endl;
+	    exit(-1);
+	}
+	Checkpoint c;
+	loadcheckpoint(ckfile,c);
+	if (c.genopt!=ck.genopt || c.format!=ck.format || c.topk!=ck.topk || c.nweights!=ck.nweights ||
+	    c.gtrees!=ck.gtrees || c.strees!=ck.strees || c.sthash!=ck.sthash || c.gthash!=ck.gthash)
+	{
+	    cerr << "Checkpoint " << ckfile << " belongs to another run" << endl;
+	    exit(-1);
+	}
+	ck=c;
+	// the output up to the checkpoint is kept, the rest is written again
+	if (outname && ck.outpos>=0 && truncate(outname,ck.outpos))
+	{
+	    cerr << "Cannot truncate " << outname << endl;
+	    exit(-1);
+	}
+	if (distname && (ck.distpos<0 || truncate(distname,ck.distpos)))
+	{
+	    cerr << "Cannot truncate " << distname << endl;
+	    exit(-1);
+	}
+    }
+    else ck.si=ck.gi=-1;
+
+    if (outname)
+    {
+	if (!(out=zopen(outname,resume ? "a" : "w")))
+	{
+	    cerr << "Cannot open file " << outname << endl;
+	    exit(-1);
+	}
+	cout.rdbuf(new zfilebuf(out));
+    }
+    if (distname) distout=new DistWriter(distname,resume);
+
+    if (streamname)
+    {
+	if (stset.size() || ckfile || shardfile || matrixname || nullsamples || famtree.size() || editfile ||
+	    weights.size() || topk>=0 || (genopt & (OPT_PAIRBYPAIR|OPT_VOTING|OPT_PRINTSPECIES)))
+	{
+	    cerr << "-y takes the place of -s and -S, and shows only -o, -F, -c and -C" << endl;
+	    exit(-1);
+	}
+	// the gene trees once by clade, the species trees once per clade
+	if (!(genopt & OPT_PROJECT)) genopt|=OPT_HASHCONS;
+    }
+
+    if ((genopt & OPT_HASHCONS) && (genopt & OPT_PROJECT))
+    {
+	cerr << "-H and -I cannot be combined" << endl;
+	exit(-1);
+    }
+    if (genopt & OPT_PROJECT)
+	for (stpos=stset.begin(); stpos !=stset.end(); ++stpos)
+	    (*stpos)->preparelca();
+
+    CladeTable *clades = NULL;
+    if (genopt & OPT_HASHCONS)
+    {
+	clades = new CladeTable;
+	for (gtpos=gtset.begin(); gtpos !=gtset.end(); ++gtpos)
+	    (*gtpos)->hashcons(*clades);
+	cerr << "Clades: " << clades->size() << " distinct of " << clades->subtrees 
+	     << " subtrees, sharing ratio " << (clades->size() ? 1.0*clades->subtrees/clades->size() : 0) << endl;
+    }
 
-    if (genopt & OPT_PRINTGENE)
+    // a resumed run has written all this before its checkpoint
+    if ((genopt & OPT_PRINTGENE) && !resume)
     {
 	for (gtpos=gtset.begin(); gtpos !=gtset.end(); ++gtpos)
 	    (*gtpos)->print(cout) << endl;
     }
 
-    if (genopt & OPT_PRINTSPECIES)
+    if ((genopt & OPT_PRINTSPECIES) && !resume)
 			{
 				for (stpos=stset.begin(); stpos !=stset.end(); ++stpos){				
 					(*stpos)->print(cout) << endl;
 				}
 			}
 
-    if (genopt & OPT_PRINTROOTED) 
+    if ((genopt & OPT_PRINTROOTED) && !resume) 
     { 
 	for (gtpos=gtset.begin(); gtpos !=gtset.end(); ++gtpos)
 	    (*gtpos)->pprooted(cout);   
     }
 
-    if (genopt & OPT_VOTING)
+    // integral weights (the default) take the exact integer path
+    int intweights = integralweights();
+
+    if ((genopt & OPT_VOTING) && !resume)
     {
+	vector<double> votes;
+	if (intweights) voting<IntWeights>(gtset,stset,clades,genopt & OPT_PROJECT,votes);
+	else voting<RealWeights>(gtset,stset,clades,genopt & OPT_PROJECT,votes);
+	for (size_t i=0; i<stset.size(); i++)
+	    if (shardfile) part.sum[i].votes=votes[i];
+	    else cout << *stset[i] << " " << votes[i] << endl;   
+    }
 
-	int trnum = stset.size();
-	double mincnts[trnum];
-	int i;
+    if (matrixname && !resume)
+	writematrix(matrixname,gtset,stset,clades,genopt & OPT_PROJECT);
 
-	for (i=0; i<trnum; i++) mincnts[i]=0;
+    if (nullsamples && !resume)
+    {
+	cerr << "Null model seed: " << nullseed << endl;
+	if (intweights) nullmodel<IntWeights>(gtset,stset,nullsamples,nullseed,genopt & OPT_PROJECT,gfirst);
+	else nullmodel<RealWeights>(gtset,stset,nullsamples,nullseed,genopt & OPT_PROJECT,gfirst);
+    }
 
-	int j=0;
-	for (gtpos=gtset.begin(); gtpos !=gtset.end(); ++gtpos)
+    if (famtree.size() && !resume)
+    {
+	if (genopt & OPT_PROJECT)
+	{
+	    cerr << "-f and -I cannot be combined" << endl;
+	    exit(-1);
+	}
+	vector<Family> families;
+	map<string,int> byname;
+	for (size_t i=0; i<famtree.size(); i++)
 	{
-	    j++;
-	    double min=0;
-	    int minc=0;
-	    UTree *g=*gtpos;
-	    i=0;
-	    for (stpos=stset.begin(); stpos !=stset.end(); ++stpos)
+	    map<string,int>::iterator f=byname.find(famof[i]);
+	    if (f==byname.end())
 	    {
-		g->clear();
-		UNode *un=g->findoptimaledge(*stpos);		
-		double m=(un->cost(*stpos)).mut();
-		if (i==0) { min=m; minc=1; }
-		else 
-		    if (min>m) { min=m; minc=1; }
-		    else if (min==m) minc++;
-		i++;
+		f=byname.insert(make_pair(famof[i],families.size())).first;
+		families.push_back(Family());
+		families.back().name=famof[i];
+		families.back().clades=clades ? clades : new CladeTable;
 	    }
-	    i=0;
- 	    for (stpos=stset.begin(); stpos !=stset.end(); ++stpos)
- 	    {		
-		g->clear();
- 		UNode *un=g->findoptimaledge(*stpos);		
- 		if ((un->cost(*stpos)).mut()==min)
-		    mincnts[i]+=1.0/minc;
- 		i++;
- 	    }
-	    
+	    families[f->second].trees.push_back(famtree[i]);
+	    if (!clades) gtset[famtree[i]]->hashcons(*families[f->second].clades);
 	}
-	i=0;
-	for (stpos=stset.begin(); stpos !=stset.end(); ++stpos)
-	    cout << **stpos << " " << mincnts[i++] << endl;   
+	if (intweights) rootsupport<IntWeights>(gtset,families,stset,clades);
+	else rootsupport<RealWeights>(gtset,families,stset,clades);
+	if (!clades)
+	    for (size_t i=0; i<families.size(); i++) delete families[i].clades;
     }
 
+    if (editfile)
+    {
+	if (gtset.size()!=1 || !stset.size() || (genopt & OPT_HASHCONS) || prune_absent)
+	{
+	    cerr << "-Y needs one gene tree and a species tree, without -H or -t" << endl;
+	    exit(-1);
+	}
+	editscript(editfile,gtset[0],stset[0]);
+    }
+
+    if (streamname) streamspecies(streamname,gtset,clades,genopt,format,intweights);
+
     if (genopt & OPT_BYCOST)
     {
-	for (stpos=stset.begin(); stpos !=stset.end(); ++stpos)
+	int si=0;
+	time_t cktime=time(0);
+	PairCosts *pairs=NULL;
+	int pairsfrom=0, pairsto=0;
+	for (stpos=stset.begin(); stpos !=stset.end(); ++stpos, ++si)
 	{		
+	    if (si<ck.si) continue; // done before the checkpoint
 	    SpeciesTree *s = *stpos;
-	    if (genopt & OPT_RECINFO) 
-		cout << " SPECIES TREE: " << endl << *s << endl;
+	    if (si!=ck.si || !ck.gi)
+	    {
+		if (genopt & OPT_RECINFO) 
+		    cout << " SPECIES TREE: " << endl << *s << endl;
+		ck.gi=0;
+		ck.sum.total=DlCost();
+		ck.sum.wtotal.assign(weights.size(),0);
+		ck.sum.wdltotal.assign(weights.size(),Rooting());
+		ck.sum.dist.assign(s->size(),DlCost());
+	    }
 
-	    DlCost total;
+	    // the totals live in ck, so that -K can save them
+	    DlCost &total=ck.sum.total;
+	    vector<double> &wtotal=ck.sum.wtotal;
+	    vector<Rooting> &wdltotal=ck.sum.wdltotal;
+	    vector<DlCost> &dist=ck.sum.dist;
+	    if (!(genopt & OPT_PAIRBYPAIR) && !weights.size() && topk<0 && !ckfile && si>=pairsto)
+	    {
+		delete pairs;
+		pairsfrom=si;
+		pairsto=min(si+pairsblock(gtset.size()),(int)stset.size());
+		pairs=new PairCosts(gtset,vector<SpeciesTree*>(stset.begin()+pairsfrom,stset.begin()+pairsto),clades,genopt & OPT_PROJECT);
+		pairs->run();
+	    }
+	    CladeMemo *memo = (clades && !pairs) ? new CladeMemo(*clades,s) : NULL;
 		    
-	    for (gtpos=gtset.begin(); gtpos !=gtset.end(); ++gtpos)
+	    for (gtpos=gtset.begin()+ck.gi; gtpos !=gtset.end(); ++gtpos)
 	    {
 		UTree *g=*gtpos;
-		g->clear();
+		if (pairs)
+		{
+		    PairCost &p=pairs->at(gtpos-gtset.begin(),si-pairsfrom);
+		    if (format) printedge(format,si,gfirst+(gtpos-gtset.begin()),0,p);
+		    if (genopt & OPT_RECMINCOST) cout << p.cost << endl;
+		    total.dup+=p.cost.dup;
+		    total.loss+=p.cost.loss;
+		    continue;
+		}
+		SpeciesTree *sp = (genopt & OPT_PROJECT) ? projection(s,g) : s;
+		ReconcileContext rc(g,sp,&dist[0]);
+		if (memo) rc.usememo(memo);
 
 		if (genopt & OPT_RECINFO) 
 		{ 
@@ -335,59 +1171,148 @@ int  main(int argc, char **argv)
 		    UNode *ur;
 		    while ((ur=itu())!=0)
 		    {
+			if (rc.cut(ur) || !ur->M(rc)) continue; // -t
 			if (ur->leaf())
 			    cout << "** leaf " << ((ULeaf*)ur)->label();
 			else {
 			    cout << "** int  " ;
-			    if (genopt & OPT_RECDETAILS) cout << "  " << *ur->smprooted() 
+			    if (genopt & OPT_RECDETAILS) cout << "  " << *ur->smprooted(&rc) 
 						       << endl;		    		
 			}
-			if (genopt & OPT_RECDETAILS) cout << "  p=" << *ur->p()->smprooted() << endl;
-			cout << "\t sc=" << ur->sc(s);
-			cout << "\t cost=" << ur->cost(s) << "\t ";
-			cout << *ur->smprooted() << " ==> " << *ur->M(s) << endl;
+			if (genopt & OPT_RECDETAILS) cout << "  p=" << *ur->p(rc)->smprooted(&rc) << endl;
+			cout << "\t sc=" << ur->sc(rc);
+			cout << "\t cost=" << ur->cost(rc) << "\t ";
+			cout << *ur->smprooted(&rc) << " ==> " << *ur->M(rc)->orig() << endl;
 		    }
 		}
 		
 		UNode *un = NULL;
 
-		if (genopt & (OPT_RECMINROOTING|OPT_RECMINCOST|OPT_RECTREECOSTDETAILS|OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL| OPT_SUMMARYDISTRIBUTIONS|OPT_TREEDISTRIBUTIONS))
-		    un=g->findoptimaledge(s);
-		  
-		if (genopt & OPT_RECMINROOTING) cout <<  *un->rooted() << endl;
+		if (format || (genopt & (OPT_RECMINROOTING|OPT_RECMINCOST|OPT_RECTREECOSTDETAILS|OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL| OPT_SUMMARYDISTRIBUTIONS|OPT_TREEDISTRIBUTIONS|OPT_DISTFILE|OPT_EVENTS)))
+		    un=g->findoptimaledge(rc);
 
-		if (genopt & OPT_RECMINCOST) cout << un->cost(s) << endl;
+		if (topk>=0)
+		{
+		    nodset r;
+		    if (intweights) g->rootings<IntWeights>(rc,topk,r);
+		    else g->rootings<RealWeights>(rc,topk,r);
+		    for (size_t i=0; i<r.size(); i++)
+			cout << (i ? " " : "") << g->edgeid(r[i],rc) << r[i]->cost(rc);
+		    cout << endl;
+		}
+
+		if (weights.size())
+		{
+		    vector<Rooting> best;
+		    g->optimaledges(rc,weights,best);
+		    for (size_t k=0; k<weights.size(); k++)
+		    {
+			if (genopt & OPT_RECMINROOTING) cout << *best[k].edge->rooted(&rc) << endl;
+			if (format) 
+			{
+			    PairCost p;
+			    p.cost=DlCost(best[k].dup,best[k].loss);
+			    g->edgeends(best[k].edge,p.a,p.v,rc);
+			    printedge(format,si,gfirst+(gtpos-gtset.begin()),k,p);
+			}
+			if (genopt & OPT_EVENTS) printevents(format,si,gfirst+(gtpos-gtset.begin()),k,g,best[k].edge,rc);
+			wtotal[k]+=best[k].mut(weights[k]);
+			wdltotal[k].dup+=best[k].dup;
+			wdltotal[k].loss+=best[k].loss;
+			wdltotal[k].dc+=best[k].dc;
+		    }
+		    if (genopt & OPT_RECMINCOST) 
+		    {
+			for (size_t k=0; k<weights.size(); k++) cout << best[k] << "\t";
+			cout << endl;
+		    }
+		}
+		else
+		{  
+		    if (genopt & OPT_RECMINROOTING) cout <<  *un->rooted(&rc) << endl;
+
+		    if (format) 
+		    {
+			PairCost p;
+			p.cost=un->cost(rc);
+			g->edgeends(un,p.a,p.v,rc);
+			printedge(format,si,gfirst+(gtpos-gtset.begin()),0,p);
+		    }
+		    if (genopt & OPT_EVENTS) printevents(format,si,gfirst+(gtpos-gtset.begin()),0,g,un,rc);
+
+		    if (genopt & OPT_RECMINCOST) cout << un->cost(rc) << endl;
+		}
 		
 		if (genopt & OPT_RECTREECOSTDETAILS)
 		{
-		    if (un->p()) un->p()->mark(2|8);
-		    un->mark(2);
-		    g->pf(cout,s);
+		    if (un->p(rc)) un->p(rc)->mark(rc,2|8);
+		    un->mark(rc,2);
+		    g->pf(cout,rc);
 		}
 		
 		if ((genopt & OPT_SUMMARYTOTAL)||(genopt & OPT_SUMMARYDLTOTAL))
 		{
-		    DlCost s1 = un->cost(s);
+		    DlCost s1 = un->cost(rc);
 		    total.loss+=s1.loss;
 		    total.dup+=s1.dup;
 		}
  
-		if ((genopt & OPT_SUMMARYDISTRIBUTIONS) || (genopt & OPT_TREEDISTRIBUTIONS)) un->costdet(s);
-	    } // gt-loop		
+		if (genopt & (OPT_SUMMARYDISTRIBUTIONS|OPT_TREEDISTRIBUTIONS|OPT_DISTFILE)) un->costdet(rc);
+		if (sp!=s) delete sp;
 
-	    if (genopt & (OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL|OPT_SUMMARYDISTRIBUTIONS))
-		cout << *s << "\t";
+		if (ckfile && time(0)>=cktime+ckinterval)
+		{
+		    ck.si=si;
+		    ck.gi=gtpos-gtset.begin()+1;
+		    cout.flush();
+		    ck.outpos = out ? zsync(out) : -1;
+		    ck.distpos = distout ? distout->sync() : -1;
+		    savecheckpoint(ckfile,ck);
+		    cktime=time(0);
+		}
+	    } // gt-loop		
 
-	    if (genopt & OPT_SUMMARYTOTAL) cout << total.mut() << "\t";
-	    if (genopt & OPT_SUMMARYDLTOTAL) cout << total << "\t";
+	    // a shard leaves the summary to urec-merge
+	    if (shardfile) 
+	    {
+		ck.sum.votes=part.sum[si].votes;
+		part.sum[si]=ck.sum;
+	    }
+	    else printsummary(s,genopt,intweights,ck.sum);
+	    if (distout) distout->write(si,&dist[0],dist.size());
+	    delete memo;
 
-	    if (genopt & (OPT_SUMMARYTOTAL|OPT_SUMMARYDLTOTAL|OPT_SUMMARYDISTRIBUTIONS))
-		cout << endl;
-	    
-	    if (genopt & OPT_SUMMARYDISTRIBUTIONS) s->showcostdet(cout);
-	    if (genopt & OPT_TREEDISTRIBUTIONS) s->pfcostdet(cout);
+	    if (ckfile)
+	    {
+		ck.si=si+1;
+		ck.gi=0;
+		cout.flush();
+		ck.outpos = out ? zsync(out) : -1;
+		ck.distpos = distout ? distout->sync() : -1;
+		savecheckpoint(ckfile,ck);
+		cktime=time(0);
+	    }
 	    
 	} // st-loop
+	delete pairs;
     } // (OPT_BYCOST)
 
+    if (prune_absent)
+	cerr << pruned_leaves << " gene leaves not in the species tree taken out, in " << pruned_pairs << " reconciliations" << endl;
+
+    // the run is complete
+    delete distout;
+    if (shardfile) saveshard(shardfile,part);
+    if (ckfile) unlink(ckfile);
+
+    if (out) 
+    {
+	cout.flush();
+	delete cout.rdbuf(coutbuf);
+	if (fclose(out))
+	{
+	    cerr << "Cannot write the output" << endl;
+	    exit(-1);
+	}
+    }
 }
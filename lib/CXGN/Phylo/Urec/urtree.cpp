@@ -9,9 +9,11 @@
 
 #include <ctype.h>
 #include <iostream>
+#include <algorithm>
 using namespace std;
 
 #include "urtree.h"
+#include "parallel.h"
 
 iterator_utree::iterator_utree(UTree *t, int flag_) : flag(flag_)
 {
@@ -50,6 +52,113 @@ ostream& UNode3::pprooted(ostream&s,int from)
     return s;
 }
 
+UTree::~UTree()
+{
+    for (nodset::iterator i=nodev.begin(); i!=nodev.end(); ++i) delete *i;
+}
+
+// ids of the nodes; edges get the id of the other direction, or, for
+// generated trees, the next free id
+void UTree::number()
+{
+    nodev.clear();
+    if (!start) return;
+    start->insert(&nodev);
+    if (start->p()) start->p()->insert(&nodev);
+    int e=0;
+    for (size_t i=0; i<nodev.size(); i++) 
+    {
+	nodev[i]->id(i);
+	if (nodev[i]->eid()>=e) e=nodev[i]->eid()+1;
+    }
+    for (size_t i=0; i<nodev.size(); i++)
+    {
+	UNode *u=nodev[i];
+	if (!u->p() || u->eid()>=0) continue;
+	if (u->p()->eid()>=0) u->eid(u->p()->eid());
+	else { u->eid(e); u->p()->eid(e++); }
+    }
+    freeeid=e;
+    for (size_t i=0; i<polyv.size(); i++)
+	if (!polyv[i].root) polyv[i].up=polyv[i].tops.back()->eid();
+}
+
+int prune_absent=0;
+long pruned_leaves=0, pruned_pairs=0;
+
+ReconcileContext::ReconcileContext(UTree *g, SpeciesTree *s, DlCost *dist) :
+    gt(g), st(s), dc(dist), memo(NULL), clade(NULL), Mn(g->size()), scn(g->size()), costn(g->size()),
+    computed(g->size()), ismarked(g->size()), startn(NULL), pruned(0)
+{
+    if (g->polytomies()) g->resolve(*this);
+    if (prune_absent && (pruned=g->prune(*this)))
+    {
+	__sync_fetch_and_add(&pruned_leaves,pruned);
+	__sync_fetch_and_add(&pruned_pairs,1);
+    }
+}
+
+void ReconcileContext::reset()
+{
+    fill(computed.begin(),computed.end(),0);
+    fill(ismarked.begin(),ismarked.end(),0);
+}
+
+void ReconcileContext::reshape()
+{
+    if (!pv.empty()) return;
+    pv.resize(gt->size());
+    ev.resize(gt->size());
+    for (int i=0; i<gt->size(); i++)
+    {
+	pv[i]=gt->node(i)->p();
+	ev[i]=gt->node(i)->eid();
+    }
+}
+
+void ReconcileContext::join(UNode *a, UNode *b)
+{
+    reshape();
+    pv[a->id()]=b;
+    pv[b->id()]=a;
+}
+
+UNode *ReconcileContext::start()
+{
+    return startn ? startn : gt->start;
+}
+
+int ReconcileContext::cut(UNode *u)
+{
+    return !pv.empty() && !pv[u->id()] && u->p();
+}
+
+void ReconcileContext::usememo(CladeMemo *m)
+{
+    // clade ids are those of the parsed shape, not of the resolved or pruned one
+    if (gt->polytomies() || pruned) return;
+    memo=m;
+    clade=gt->clades();
+}
+
+int UTree::cladeof(UNode *u, CladeTable &t)
+{
+    int &c = cladev[u->id()];
+    if (c<0)
+    {
+	if (u->leaf()) c=t.leaf(((ULeaf*)u)->label());
+	else c=t.join(cladeof(((UNode3*)u)->l()->p(),t),cladeof(((UNode3*)u)->r()->p(),t));
+	t.subtrees++;
+    }
+    return c;
+}
+
+void UTree::hashcons(CladeTable &t)
+{
+    cladev.assign(nodev.size(),-1);
+    for (size_t i=0; i<nodev.size(); i++) cladeof(nodev[i],t);
+}
+
 ostream& UTree::pprooted(ostream&s)
 {
     return start->pprooted(s,0);
@@ -57,36 +166,222 @@ ostream& UTree::pprooted(ostream&s)
 
 UNode *UTree::parseNode(char *s, int &p, int fromroot)
 {
-	char *cur = getTok(s,p);
+	int pre = parsed++;
+	char *cur = nodeTok(s,p);
 	if (cur[0]=='(')
     {
-			UNode *a = parseNode(s,p,0);
-			getTok(s,p); // this should return a comma
-			UNode *b = parseNode(s,p,0);
-			cur=getTok(s,p); // this should return a )
-			if (fromroot) 
+			nodset kids;
+			do kids.push_back(parseNode(s,p,0));
+			while (closeTok(s,p,kids.size())[0]==',');
+			if (!fromroot && islabel(s,p))
 				{
-					if (cur[0]==',')
-						{
-							a=createNode3(a,b);
-							b=parseNode(s,p,0);
-							getTok(s,p);
-						}
-					// join a<->b
-					a->p(b);
-					b->p(a);
-					return start=b;
-				}	
-			if(s[p]==':'){ 
-				int start = p; 
-				getTok(s,p); 	
-				return createNode3(a,b,s+start,p-start) ; 
-			}
-			else{ return createNode3(a,b); }		
+					char *l = getTok(s,p);
+					return internal(kids,pre,0,l,s+p-l);
+				}
+			return internal(kids,pre,fromroot);
     }        
-	return start=createLeaf(cur,s+p-cur);
+	start=createLeaf(cur,s+p-cur);
+	start->eid(pre);
+	return start;
+}
+
+// Joins the parsed children of the node with preorder index pre. More than
+// two children are built as ((a,b),c),... for now, see resolve().
+UNode *UTree::internal(nodset &kids, int pre, int fromroot, char *l, int len)
+{
+	if (kids.size()<2)
+		{
+			if (!fromroot) return kids[0];
+			cerr << "Parse error: a tree needs two leaves" << endl;
+			exit(-1);
+		}
+	if ((int)uppre.size()<parsed) uppre.resize(parsed,-1);
+	for (size_t i=0; i<kids.size(); i++) uppre[kids[i]->eid()]=pre;
+	UNode *a=kids[0], *b=kids[1];
+	Polytomy t;
+	t.pre=pre;
+	t.root=fromroot;
+	for (size_t i=2; i<kids.size(); i++)
+		{
+			a=createNode3(a,b);
+			a->eid(pre);
+			t.tops.push_back((UNode3*)a);
+			b=kids[i];
+		}
+	if (fromroot) 
+		{
+			if (t.tops.size()) a->eid(b->eid());
+			else 
+				{
+					uppre[a->eid()]=b->eid();
+					b->eid(a->eid()); // the root's two edges are one
+				}
+			// join a<->b
+			a->p(b);
+			b->p(a);
+			// three children of the root are an unrooted binary node
+			if (t.tops.size()>1) polyv.push_back(t);
+			return start=b;
+		}	
+	UNode *u;
+	if (len) u=createNode3(a,b,l,len);
+	else u=createNode3(a,b);
+	u->eid(pre);
+	if (t.tops.size())
+		{
+			t.tops.push_back((UNode3*)u);
+			polyv.push_back(t);
+		}
+	return u;
+}
+
+// Resolves every polytomy for rc.st, innermost first, so that the
+// mappings of the children are final. The children are ordered by the
+// preorder of their mappings and the adjacent pair with the deepest lca
+// is merged until one subtree is left (two at the root). This is a
+// heuristic: the resolution need not have the least cost of all of them.
+// Only rc has that shape; it starts from the parsed one.
+void UTree::resolve(ReconcileContext &rc)
+{
+    for (size_t i=0; i<polyv.size(); i++) resolve(polyv[i],rc);
+}
+
+// children without species (-t) come first
+static int mappreorder(const pair<RNode*,UNode*> &a, const pair<RNode*,UNode*> &b) 
+{ 
+    return (a.first ? a.first->orig()->id() : -1)<(b.first ? b.first->orig()->id() : -1); 
+}
+
+void UTree::resolve(Polytomy &t, ReconcileContext &rc)
+{
+    nodset member;
+    for (size_t i=0; i<t.tops.size(); i++)
+    {
+	member.push_back(t.tops[i]);
+	member.push_back(t.tops[i]->l());
+	member.push_back(t.tops[i]->r());
+    }
+    sort(member.begin(),member.end());
+
+    // the edges leaving the group
+    UNode *up=NULL;
+    vector<pair<RNode*,UNode*> > kids;
+    for (size_t i=0; i<member.size(); i++)
+    {
+	UNode *n=member[i]->p(rc);
+	if (binary_search(member.begin(),member.end(),n)) continue;
+	if (!t.root && n->eid(rc)==t.up) up=n;
+	else kids.push_back(make_pair(n->M(rc),n));
+    }
+    sort(kids.begin(),kids.end(),mappreorder);
+
+    size_t next=0;
+    while (kids.size()>(t.root ? 2u : 1u))
+    {
+	size_t best=0;
+	int bestd=-1;
+	double bestc=0;
+	for (size_t i=0; i+1<kids.size(); i++)
+	{
+	    RNode *m1=kids[i].first, *m2=kids[i+1].first;
+	    if (!m1) { best=i; break; } // prune() takes it out
+	    RNode *m=rc.st->lca(m1,m2);
+	    int d=m->depth();
+	    double c=DlCost(dupprim(m,m1,m2),lossprim(m,m1,m2)).mut();
+	    if (d>bestd || (d==bestd && c<bestc)) { bestd=d; bestc=c; best=i; }
+	}
+	UNode3 *c=t.tops[next++];
+	UNode *x=kids[best].second, *y=kids[best+1].second;
+	// as connect(c->l(),c->r(),c,x,y), the triple's own links stay
+	rc.join(c->l(),x);
+	rc.join(c->r(),y);
+	rc.ev[c->l()->id()]=x->eid(rc);
+	rc.ev[c->r()->id()]=y->eid(rc);
+	rc.ev[c->id()]=t.pre;
+	if (kids[best].first) kids[best].first=rc.st->lca(kids[best].first,kids[best+1].first);
+	else kids[best].first=kids[best+1].first;
+	kids[best].second=c;
+	kids.erase(kids.begin()+best+1);
+    }
+
+    UNode *x=kids[0].second, *y = t.root ? kids[1].second : up;
+    rc.join(x,y);
+    int e = t.root ? ((x->eid(rc)==t.pre) ? y->eid(rc) : x->eid(rc)) : t.up;
+    rc.ev[x->id()]=e;
+    rc.ev[y->id()]=e;
+}
+
+static int intriple(UNode *n, UNode3 *c)
+{
+    return n==c || n==c->l() || n==c->r();
+}
+
+void UTree::edgeends(UNode *u, int &a, int &v, ReconcileContext &rc)
+{
+    v=edgeid(u,rc);
+    UNode *p=u->p(rc);
+    if (p && p->eid(rc)!=u->eid(rc))
+    {
+	// joined by prune(): its ends are the nodes of u and p
+	a=vertexpre(v==u->eid(rc) ? p : u,rc);
+	return;
+    }
+    a=(v>=0 && v<(int)uppre.size()) ? uppre[v] : -1;
+    for (size_t i=0; i<polyv.size(); i++)
+    {
+	Polytomy &t=polyv[i];
+	if (t.pre!=v) continue;
+	int in=0;
+	for (size_t j=0; j<t.tops.size(); j++)
+	    in+=intriple(u,t.tops[j])+intriple(p,t.tops[j]);
+	if (in==2) a=v;
+    }
+}
+
+// -t: a leaf u whose species is not in rc.st goes with the node c next to
+// it, whose other neighbours p1 and p2 are joined. The nodes taken out are
+// left without p(rc), so walks and edge loops do not reach them, and all
+// eid(rc) stay, so p1 and p2 keep the input edges they had (edgeid() names
+// the edge they make). Mappings skip
+// sides without species, so those computed before (resolve()) stay
+// right. The last two leaves stay, whatever their species.
+int UTree::prune(ReconcileContext &rc)
+{
+    int n=0;
+    for (size_t i=0; i<nodev.size(); i++)
+    {
+	UNode *u=nodev[i];
+	if (!u->leaf() || rc.cut(u) || u->M(rc) || !u->p(rc) || u->p(rc)->leaf()) continue;
+	UNode3 *c=(UNode3*)u->p(rc), *a=c->l(), *b=c->r();
+	UNode *p1=a->p(rc), *p2=b->p(rc);
+	rc.join(p1,p2);
+	rc.pv[u->id()]=rc.pv[c->id()]=rc.pv[a->id()]=rc.pv[b->id()]=NULL;
+	if (rc.cut(rc.start())) rc.startn=p1;
+	n++;
+    }
+    return n;
 }
 
+// Every edge joins uppre[e] and e, its eid() e, but the two edges of a
+// binary root are one, with uppre[e]>e, whose upper end is the start
+// leaf or triple. The three edges of a triple share its node; only edges
+// inside a resolved polytomy can all be the same pair, lower end e.
+int UTree::vertexpre(UNode *u, ReconcileContext &rc)
+{
+    int e=u->eid(rc);
+    if (e<0 || e>=(int)uppre.size()) return -1;
+    if (u->leaf()) return (uppre[e]>e && u==start) ? uppre[e] : e;
+    UNode3 *t=(UNode3*)u;
+    int v[3] = { e, t->l()->eid(rc), t->r()->eid(rc) };
+    int in[2] = { 0, 0 };
+    for (int k=1; k<3; k++)
+    {
+	int a = (v[k]>=0 && v[k]<(int)uppre.size()) ? uppre[v[k]] : -1;
+	in[0]+=(v[k]==e || a==e);
+	in[1]+=(v[k]==uppre[e] || a==uppre[e]);
+    }
+    return (in[0]==2 || in[1]<2) ? e : uppre[e];
+}
 
 UNode3* UTree::connect(UNode3 *a, UNode3 *b, UNode3 *c, UNode *u1, UNode *u2)
 {
@@ -103,46 +398,117 @@ UNode3* UTree::connect(UNode3 *a, UNode3 *b, UNode3 *c, UNode *u1, UNode *u2)
     return c;
 }
 
-UNode *UTree::findoptimaledge(SpeciesTree *st)
+UNode *UTree::findoptimaledge(ReconcileContext &rc)
 {
+    SpeciesTree *st = rc.st;
 #define shw(k) 
-    UNode *cur = start;
+    UNode *cur = rc.start();
     shw("start");
-    cur->mark(4|1);
-    if (!cur->p()) return cur;
-    if (cur->leaf() && cur->p()->leaf()) return cur;
-    if (cur->leaf()) cur=cur->p();
+    cur->mark(rc,4|1);
+    if (!cur->p(rc)) return cur;
+    if (cur->leaf() && cur->p(rc)->leaf()) return cur;
+    if (cur->leaf()) cur=cur->p(rc);
 
     shw("init");
     // cur - internal
     int i;
     int found=0;     
-    RNode *MG = st->lca(cur->M(st),cur->p()->M(st));
+    RNode *MG = st->lca(cur->M(rc),cur->p(rc)->M(rc));
     if (MG->leaf()) return cur; // |L(G)|=1
     for (i=0; i<3; i++, cur=((UNode3*)cur)->l()) 
-	if (cur->M(st)!=MG) { found=1; break; }
-    cur->mark();
+	if (cur->M(rc)!=MG) { found=1; break; }
+    cur->mark(rc);
     shw("ins");
     if (found)
     {
-	while (!cur->p()->leaf())
+	while (!cur->p(rc)->leaf())
 	{
 	    shw("wh");
-	    UNode3 *cur3p = (UNode3*)cur->p();
-	    if (cur3p->l()->M(st)!=MG) cur=cur3p->l();
+	    UNode3 *cur3p = (UNode3*)cur->p(rc);
+	    if (cur3p->l()->M(rc)!=MG) cur=cur3p->l();
 	    else
-		if (cur3p->r()->M(st)!=MG) cur=cur3p->r();	    
+		if (cur3p->r()->M(rc)!=MG) cur=cur3p->r();	    
 		else { cur=cur3p; break; }
-	    cur->mark();
+	    cur->mark(rc);
 	}
-	if (cur->M(st)!=MG) return cur;
+	if (cur->M(rc)!=MG) return cur;
     }
-    cur->mark();
+    cur->mark(rc);
     for (i=0; i<3; i++, cur=((UNode3*)cur)->l()) 
-	if (cur->p()->M(st)==MG) return cur;
+	if (cur->p(rc)->M(rc)==MG) return cur;
     return cur;     
 }
 
+static int preorder(RNode *a, RNode *b) { return a->orig()->id()<b->orig()->id(); }
+
+// number of nodes of the smallest subtree of the species tree containing
+// the species of the gene tree: sorted by preorder, the cyclic walk through
+// them passes every edge of that subtree twice
+int UTree::spannodes(ReconcileContext &rc)
+{
+    vector<RNode*> lv;
+    for (size_t i=0; i<nodev.size(); i++)
+	if (nodev[i]->leaf() && nodev[i]->M(rc)) lv.push_back(nodev[i]->M(rc));
+    sort(lv.begin(),lv.end(),preorder);
+    lv.erase(unique(lv.begin(),lv.end()),lv.end());
+    int len=0;
+    for (size_t i=0; i<lv.size(); i++)
+    {
+	RNode *a=lv[i], *b=lv[(i+1)%lv.size()];
+	len+=a->depth()+b->depth()-2*rc.st->lca(a,b)->depth();
+    }
+    return len/2+1;
+}
+
+// The optimal rooting under every weight vector of w, from one mapping of
+// the gene tree. Deep coalescence of a rooting follows from its counts:
+// DC = L - 2D + |V(G)| - |V(S')|, where S' is the subtree of the species
+// tree spanned by the species of G, the same for all rootings.
+void UTree::optimaledges(ReconcileContext &rc, vector<Weights> &w, vector<Rooting> &best)
+{
+    int leaves=0;
+    for (size_t i=0; i<nodev.size(); i++)
+	if (nodev[i]->leaf() && nodev[i]->M(rc)) leaves++;
+    int dcoffset = 2*leaves-1-spannodes(rc);
+    Rooting r;
+    r.edge=rc.start();
+    r.dup=r.loss=r.dc=0;
+    best.assign(w.size(),r);
+    vector<double> min(w.size());
+    int first=1;
+    for (size_t i=0; i<nodev.size(); i++)
+    {
+	UNode *u=nodev[i];
+	if (!u->p(rc) || u->id()>u->p(rc)->id()) continue; // every edge once
+	DlCost &c=u->cost(rc);
+	r.edge=u;
+	r.dup=c.dup;
+	r.loss=c.loss;
+	r.dc=c.loss-2*c.dup+dcoffset;
+	for (size_t k=0; k<w.size(); k++)
+	{
+	    double m=r.mut(w[k]);
+	    if (first || m<min[k]) { min[k]=m; best[k]=r; }
+	}
+	first=0;
+    }
+}
+
+// the species tree induced by the species of g (-I), or s itself if none
+// of them is in s; s must have had preparelca() called
+SpeciesTree *projection(SpeciesTree *s, UTree *g)
+{
+    vector<RNode*> lv;
+    for (int i=0; i<g->size(); i++)
+	if (g->node(i)->leaf())
+	{
+	    RNode *l = s->getLeaf(((ULeaf*)g->node(i))->label());
+	    if (l) lv.push_back(l);
+	}
+    if (lv.empty()) return s;
+    return new ProjectedTree(s,lv);
+}
+
 int lossprim(RNode *s,RNode *s1,RNode *s2)
 {
     if ((s!=s1) && (s!=s2)) return s1->depth()+s2->depth()-2*s->depth()-2;
@@ -150,35 +516,35 @@ int lossprim(RNode *s,RNode *s1,RNode *s2)
     return s2->depth()-s->depth();
 }
 
-void dlcostdetintermediates(RNode *child, RNode *cur,RNode *last, int skiplast=1)
+void dlcostdetintermediates(RNode *child, RNode *cur,RNode *last, DlCost *dc, int skiplast=1)
 {
     while (1) 
     {
 	if ((cur==last) && (skiplast)) return;
-	if (child==((RInt*)cur)->l()) ((RInt*)cur)->r()->costdet().loss++;
-	else ((RInt*)cur)->l()->costdet().loss++;
+	if (child==((RInt*)cur)->l()) dc[((RInt*)cur)->r()->id()].loss++;
+	else dc[((RInt*)cur)->l()->id()].loss++;
 	if (cur==last) return;
 	cur=cur->p();
 	child=child->p();
     }
 }
 
-void dlcostdet(RNode *s,RNode *s1,RNode *s2)
+void dlcostdet(RNode *s,RNode *s1,RNode *s2,DlCost *dc)
 {
     //loss
     if ((s!=s1) && (s!=s2)) 
 	{
-	    dlcostdetintermediates(s1,s1->p(),s);
-	    dlcostdetintermediates(s2,s2->p(),s);
+	    dlcostdetintermediates(s1,s1->p(),s,dc);
+	    dlcostdetintermediates(s2,s2->p(),s,dc);
 	}
     else
     {
 	if (s!=s1) 
-	    dlcostdetintermediates(s1,s1->p(),s,0);
+	    dlcostdetintermediates(s1,s1->p(),s,dc,0);
 	else
 	    if (s!=s2) 
-		dlcostdetintermediates(s2,s2->p(),s,0);    
-	s->costdet().dup++;
+		dlcostdetintermediates(s2,s2->p(),s,dc,0);    
+	dc[s->id()].dup++;
     }
 }
 
@@ -222,6 +588,7 @@ UTree::UTree(int len,double pint, double dec, int numlv, int uniquelv, char *src
 	    t[i]=strdup(buf);
 	  }
 	initrand(len,pint,dec,t,splen);
+	number();
       }
     else
       {
@@ -276,6 +643,7 @@ UTree::UTree(int len,double pint, double dec, int numlv, int uniquelv, char *src
 	if (lf==1) 
 	  {
 	    start = tb[0];
+	    number();
 	    return;
 	  }
 
@@ -305,6 +673,7 @@ UTree::UTree(int len,double pint, double dec, int numlv, int uniquelv, char *src
 	tb[0]->p(tb[1]);
 	tb[1]->p(tb[0]);
 	start=tb[0];
+	number();
     	
 // 	cout << " " << lf << " " << uniquelv << endl;
 // 	start->ppsmprooted(cout); cout << endl;
@@ -325,6 +694,80 @@ UTree::UTree(int len,double pint, double dec, SpeciesTree *sp)
     while ((r=(RLeaf*)it())!=0) t[i++]=r->label();
     t[sp->lsize()]=0;
     initrand(len,pint,dec,(char**)t,sp->lsize());
+    number();
+}
+
+// as the numlv constructor, with the leaf multiset of g
+UTree::UTree(UTree *g, unsigned int *seed)
+{
+    nodset tb;
+    for (int i=0; i<g->size(); i++)
+	if (g->node(i)->leaf()) tb.push_back(createLeaf(((ULeaf*)g->node(i))->complete()));
+    int lf=tb.size();
+    start=NULL;
+    if (!lf) return;
+    for (int i=0; i<lf-2; i++)
+    {
+	int p = rand_r(seed)%(lf-i);
+	int q;
+	do q = rand_r(seed)%(lf-i);
+	while (p==q);
+	tb[p] = createNode3(tb[p],tb[q]);
+	tb.erase(tb.begin()+q);
+    }
+    if (lf>1)
+    {
+	tb[0]->p(tb[1]);
+	tb[1]->p(tb[0]);
+    }
+    start=tb[0];
+    number();
+}
+
+PairCosts::PairCosts(utreevec &g, vector<SpeciesTree*> s, CladeTable *ct, int pr) :
+    gt(g), st(s), memo(s.size()), r(g.size()*s.size()), project(pr)
+{
+    if (ct) for (size_t i=0; i<st.size(); i++) memo[i]=new CladeMemo(*ct,st[i]);
+}
+
+PairCosts::~PairCosts() 
+{ 
+    for (size_t i=0; i<memo.size(); i++) delete memo[i]; 
+}
+
+void PairCosts::operator()(int g, int s, int tid)
+{
+    SpeciesTree *sp = project ? projection(st[s],gt[g]) : st[s];
+    ReconcileContext rc(gt[g],sp);
+    if (memo[s]) rc.usememo(memo[s]);
+    UNode *u=gt[g]->findoptimaledge(rc);
+    PairCost &p=at(g,s);
+    p.cost=u->cost(rc);
+    gt[g]->edgeends(u,p.a,p.v,rc);
+    if (sp!=st[s]) delete sp;
+}
+
+// tile sizes: the nodes and, for gene trees, the state of a ReconcileContext
+void PairCosts::run()
+{
+    vector<long> gw(gt.size()), sw(st.size());
+    for (size_t i=0; i<gt.size(); i++) 
+	gw[i]=gt[i]->size()*(sizeof(UNode3)+sizeof(RNode*)+2*sizeof(DlCost)+2);
+    for (size_t i=0; i<st.size(); i++) 
+	sw[i]=st[i]->size()*sizeof(RInt);
+    parallel_tiles(gw,sw,*this);
 }
 
+struct NestedRunner
+{
+    PairCosts &p;
+    int ns;
+    NestedRunner(PairCosts &p_, int n) : p(p_), ns(n) {}
+    void operator()(int g, int tid) { for (int s=0; s<ns; s++) p(g,s,tid); }
+};
 
+void PairCosts::runnested()
+{
+    NestedRunner n(*this,st.size());
+    parallel_for(gt.size(),n);
+}
@@ -13,69 +13,126 @@
 #include <map>
 #include <set>
 #include <list>
+#include <vector>
+#include <algorithm>
 
 using namespace std;
 
 #include "rtree.h"
+#include "clades.h"
 
 #define C_MAP 1
 #define C_SC 2
 #define C_COST 4
 
 class UNode;
-typedef set<UNode*> nodset;
+class UTree;
+typedef vector<UNode*> nodset;
 
 extern int detailed_costs;
+// -t: gene leaves of species missing from the species tree are taken out
+// (UTree::prune), counted over all reconciliations
+extern int prune_absent;
+extern long pruned_leaves, pruned_pairs;
 int lossprim(RNode *s,RNode *s1,RNode *s2);
-void dlcostdet(RNode *s,RNode *s1,RNode *s2);
+void dlcostdet(RNode *s,RNode *s1,RNode *s2,DlCost *dc);
 #define dupprim(s,s1,s2) (( (s==s1) || (s==s2))?1:0)
 
+// State of one reconciliation of a gene tree with a species tree.
+// A gene tree with polytomies is resolved for the species tree
+// (UTree::resolve), and with -t pruned (UTree::prune), in the context:
+// pv and ev then hold the neighbour across the edge and the eid() of every
+// node for that shape, and the UTree keeps its parsed shape, so any number
+// of contexts of one gene tree, and of one SpeciesTree, can be used at
+// once, from any threads. Only the edits (edit.cpp) change a gene tree.
+// The arrays are indexed by UNode::id();
+// dc, if given, collects the -d/-x distributions and is indexed by RNode::id().
+// With a CladeMemo (-H) mappings and subtree costs are read from the memo
+// instead of being computed for this gene tree.
+class ReconcileContext
+{
+ public:
+    UTree *gt;
+    SpeciesTree *st;
+    DlCost *dc;
+    CladeMemo *memo;
+    int *clade; // UNode::id() -> clade id in memo
+    vector<RNode*> Mn;
+    vector<DlCost> scn;
+    vector<DlCost> costn;
+    vector<char> computed;
+    vector<char> ismarked;
+    vector<UNode*> pv; // UNode::p(rc), empty while it is the tree's own
+    vector<int> ev; // UNode::eid(rc), as pv
+    UNode *startn; // the start node of that shape, NULL for the tree's own
+    int pruned; // gene leaves taken out for st (-t)
+    ReconcileContext(UTree *g, SpeciesTree *s, DlCost *dist=NULL);
+    void reset();
+    void usememo(CladeMemo *m);
+    void reshape(); // pv and ev from the tree, before the first change
+    void join(UNode *a, UNode *b); // a and b become neighbours
+    UNode *start();
+    // taken out by prune()
+    int cut(UNode *u);
+};
+
 class UNode // unrooted node, I guess
 {
  protected:
 	UNode *pn;
-	RNode *Mn;    
-	DlCost scn;
-	DlCost costn;
-	int computed;
-	int ismarked;
+	int idn; // index in UTree::nodev and in the ReconcileContext arrays
+	int eidn; // edge to pn: preorder index of its lower node in the input tree
 	char* complete_label;
  public:
-		UNode(UNode *p_=NULL, char* s=NULL, int len=0) : pn(p_), Mn(NULL), computed(0), ismarked(0), complete_label("") {
-			if(s != NULL  && len > 0){	complete_label = xstrndup(s, len); }
+		// complete_label is always malloc'ed, "" if there is no label
+		UNode(UNode *p_=NULL, const char* s=NULL, int len=0) : pn(p_), idn(-1), eidn(-1) {
+			complete_label = (s != NULL  && len > 0) ? xstrndup(s, len) : xstrndup("",0);
 } 
-    virtual ~UNode() {}
-    void reset() { computed=0; Mn=NULL; ismarked=0; }
-    void mark(int m=1) { ismarked|=m; }
-    int marked() { return ismarked; }
+    virtual ~UNode() { free(complete_label); }
+    int id() { return idn; }
+    void id(int i) { idn=i; }
+    int eid() { return eidn; }
+    void eid(int i) { eidn=i; }
+    // p() and eid() in the shape of the gene tree for rc.st
+    int eid(ReconcileContext &rc) { return rc.ev.empty() ? eidn : rc.ev[idn]; }
+    void mark(ReconcileContext &rc, int m=1) { rc.ismarked[idn]|=m; }
+    int marked(ReconcileContext &rc) { return rc.ismarked[idn]; }
     virtual int leaf()=0;
-    virtual void clear()=0;
     virtual UNode *p() { return pn; }
     void p(UNode *p_) { pn=p_; }
-    DlCost &cost(SpeciesTree *st)
+    UNode *p(ReconcileContext &rc) { return rc.pv.empty() ? pn : rc.pv[idn]; }
+    UNode *p(ReconcileContext *rc) { return rc ? p(*rc) : pn; }
+    DlCost &cost(ReconcileContext &rc)
 			{
+				DlCost &costn = rc.costn[idn];
+				UNode *pn = p(rc);
 				if (!pn) return costn;
-				if (!(computed & C_COST)) 
+				if (!(rc.computed[idn] & C_COST)) 
 					{
-						RNode *s = st->lca(M(st),pn->M(st));
-						costn.loss=sc(st).loss+pn->sc(st).loss+lossprim(s,M(st),pn->M(st));
-						costn.dup=sc(st).dup+pn->sc(st).dup+dupprim(s,M(st),pn->M(st));	
-						computed|=C_COST;
+						if (!M(rc) || !pn->M(rc)) costn=DlCost(); // -t left less than two species
+						else
+							{
+								RNode *s = rc.st->lca(M(rc),pn->M(rc));
+								costn.loss=sc(rc).loss+pn->sc(rc).loss+lossprim(s,M(rc),pn->M(rc));
+								costn.dup=sc(rc).dup+pn->sc(rc).dup+dupprim(s,M(rc),pn->M(rc));	
+							}
+						rc.computed[idn]|=C_COST;
 					}
 				return costn; 
 			}
-    void costdet(SpeciesTree *st)
+    void costdet(ReconcileContext &rc)
 	{
-	    if (!pn) return; // nothing to compute (a leaf)
-	    RNode *s = st->lca(M(st),pn->M(st));
-	    dlcostdet(s,M(st),pn->M(st));
-	    costdetsubtree(st);
-	    pn->costdetsubtree(st);
+	    UNode *pn = p(rc);
+	    if (!pn || !M(rc) || !pn->M(rc)) return; // nothing to compute (a leaf, or -t left one species)
+	    RNode *s = rc.st->lca(M(rc),pn->M(rc));
+	    dlcostdet(s->orig(),M(rc)->orig(),pn->M(rc)->orig(),rc.dc);
+	    costdetsubtree(rc);
+	    pn->costdetsubtree(rc);
 	}
-    virtual void costdetsubtree(SpeciesTree *st) {}
+    virtual void costdetsubtree(ReconcileContext &rc) {}
     virtual ostream& ppsmprooted(ostream&s)=0;
-    virtual RNode *smprooted()=0;
-    virtual RNode *M(SpeciesTree *st)=0;
+    virtual RNode *smprooted(ReconcileContext *rc=NULL)=0;
+    virtual RNode *M(ReconcileContext &rc)=0;
     virtual ostream& pprooted(ostream&s, int from) {
 	if (pn) 
 	{	    
@@ -86,38 +143,41 @@ class UNode // unrooted node, I guess
 	return ppsmprooted(s);
     }
 
-    virtual RNode* rooted() {  
-	if (pn) return new RInt(smprooted(), pn->smprooted()); 
-	return smprooted();
+    virtual RNode* rooted(ReconcileContext *rc=NULL) {  
+	if (p(rc)) return new RInt(smprooted(rc), p(rc)->smprooted(rc)); 
+	return smprooted(rc);
     }
 
-    virtual nodset* insert(nodset *n)=0;
-    virtual DlCost &sc(SpeciesTree *st) { return scn; }
-    virtual ostream& pf(ostream& s, double c, SpeciesTree *st) {
+    virtual nodset* insert(nodset *n, ReconcileContext *rc=NULL)=0;
+    virtual DlCost &sc(ReconcileContext &rc) { return rc.scn[idn]; }
+    virtual ostream& pf(ostream& s, double c, ReconcileContext &rc) {
+        UNode *pn = p(rc);
         if (pn) {
             s << "(" ;
-            smppf(s,c,st) << ",";
-            return pn->smppf(s,c,st) << ")";
+            smppf(s,c,rc) << ",";
+            return pn->smppf(s,c,rc) << ")";
         }
-        return smppf(s,c,st);
+        return smppf(s,c,rc);
     }
-    virtual ostream& smppf(ostream &s,double, SpeciesTree*)=0;
-    void pcosts(ostream &s,double c,SpeciesTree *st)
+    virtual ostream& smppf(ostream &s,double, ReconcileContext&)=0;
+    void pcosts(ostream &s,double c,ReconcileContext &rc)
         {
-            s << " totalc({" << cost(st).dup << "," << cost(st).loss << "})"
-              << " treec({" << sc(st).dup << "," << sc(st).loss << "}) " ;
+            s << " totalc({" << cost(rc).dup << "," << cost(rc).loss << "})"
+              << " treec({" << sc(rc).dup << "," << sc(rc).loss << "}) " ;
 
+	    int ismarked = marked(rc);
 	    if (ismarked & 1) s << " mark(1)";
 	    if (ismarked & 2) s << " markopt(1)";
 	    if (ismarked & 4) s << " markstart(1)";
 	    if (ismarked & 8) s << " markoptm(1)";
 		
-//            if (c==cost(st).mut()) s << " minc(1) ";
-            if (M(st)->p()) s << " destn(\"" << *M(st) << "\") ";
+//            if (c==cost(rc).mut()) s << " minc(1) ";
+            if (M(rc) && M(rc)->orig()->p()) s << " destn(\"" << *M(rc)->orig() << "\") ";
             else s << " destn(\"\") ";
         }
-    virtual UNode* subtreecost(SpeciesTree *st)=0;
-    virtual UNode* mincost(SpeciesTree *st)=0;
+    // the cheapest edge of the subtree / of the whole tree under cost policy W
+    template<class W> UNode* subtreecost(ReconcileContext &rc);
+    template<class W> UNode* mincost(ReconcileContext &rc);
 };
 
 class ULeaf : public UNode  // unrooted leaf node
@@ -127,61 +187,45 @@ class ULeaf : public UNode  // unrooted leaf node
 	char* gene_id; // another label, use for e.g. sequence id
 	//	char* complete_label; // something like At435[species=Arabidopsis_thaliana]:0.1
  public:
-	ULeaf(char *lab_, UNode *p_=NULL) : UNode(p_), lab(lab_) {
+	ULeaf(char *lab_, UNode *p_=NULL) : UNode(p_, lab_, strlen(lab_)), lab(lab_) {
 		// if   for example lab_  is "gene43[species=wombat]"   then copy "wombat" into lab, "gene43" into gene_id,
 		// else just copy lab_  into both lab, gene_id
 	
-		char* label_copy = xstrndup(lab_,0);
-		complete_label = xstrndup(lab_,0);
-		char* label = strtok(label_copy, " [:"); // everything up to first space : or [
-		gene_id = xstrndup(label, 0); 
-		char* attrib_name = strtok(NULL, " [="); 
-		char* attrib_value;
-		if((attrib_name == NULL) ||  (strcmp(attrib_name, "species") != 0)  ||	( (attrib_value = strtok(NULL, " =]")) == NULL) ){
-			lab = xstrndup(label, 0);
-		}
-		else{ // [species=something] present. use it.		
-			lab = xstrndup(attrib_value, 0);
-		}
-		free(label_copy);
+		leaflabel(lab_,gene_id,lab);
+		free(lab_);
 	} 
+	// an already split label (see leaflabel)
+	ULeaf(const char *complete, const char *name, const char *species) : UNode(NULL, complete, strlen(complete)) {
+		gene_id = xstrndup(name,0);
+		lab = xstrndup(species,0);
+	}
 		//  ULeaf(char* lab_, char* gene_id_, UNode *p_=NULL) : UNode(p_), lab(lab_), gene_id(gene_id_) {} // constructor which takes care of gene_id too.
-			virtual ~ULeaf() {}
+			virtual ~ULeaf() { free(lab); free(gene_id); }
 			virtual int leaf() { return 1; }
 			char* label() { return lab; }
-			virtual void clear() { reset(); }
+			char* geneid() { return gene_id; }
+			char* complete() { return complete_label; }
 			virtual ostream& ppsmprooted(ostream&s)  { return s << OUT_LABEL; }
-			virtual RNode *smprooted()  { return new RLeaf(complete_label); }
-			virtual nodset* insert(nodset *n) { n->insert(this); return n; }
-			virtual RNode *M(SpeciesTree *st) { 
-				if (!(computed & C_MAP)) 
+			virtual RNode *smprooted(ReconcileContext *rc=NULL)  { return new RLeaf(strdup(complete_label)); }
+			virtual nodset* insert(nodset *n, ReconcileContext *rc=NULL) { n->push_back(this); return n; }
+			virtual RNode *M(ReconcileContext &rc) { 
+				if (!(rc.computed[idn] & C_MAP)) 
 					{
-						Mn=st->getLeaf(lab);
-						if (!Mn) { 
+						RNode *Mn=rc.memo ? rc.memo->M[rc.clade[idn]] : rc.st->getLeaf(lab);
+						if (!Mn && !prune_absent) { 
 							cerr << "Mapping of " << lab << " not found in the species tree." <<endl;
 							exit(-1);
 						}			 
-						computed|=C_MAP;
+						rc.Mn[idn]=Mn;
+						rc.computed[idn]|=C_MAP;
 					}
-				return Mn; 	
+				return rc.Mn[idn]; 	
 			}
-    virtual ostream& smppf(ostream& s,double c,SpeciesTree *st) { 
+    virtual ostream& smppf(ostream& s,double c,ReconcileContext &rc) { 
 			s << OUT_LABEL;
-			pcosts(s,c,st);
+			pcosts(s,c,rc);
 			return s;
     }
-    virtual UNode* subtreecost(SpeciesTree *st)
-	{
-	    cost(st);
-	    return this;
-	}
-    virtual UNode* mincost(SpeciesTree *st)
-	{
-	    cost(st);
-	    if (!pn) return this;
-	    if (pn->leaf()) return this;
-	    return pn->subtreecost(st);
-	}
 };
 
 class UNode3 : public UNode // aha! internal node. "3" because connects to 3 other nodes ???
@@ -198,37 +242,36 @@ class UNode3 : public UNode // aha! internal node. "3" because connects to 3 oth
     virtual int leaf() { return 0; }
     UNode3 *l() { return ln; }    
     UNode3 *r() { return rn; }
-    virtual void clear() { 
-	reset(); 
-	ln->reset();
-	rn->reset();
-	ln->p()->clear();
-	rn->p()->clear();
-    }
     void l(UNode3 *l_) { ln=l_; }
     void r(UNode3 *r_) { rn=r_; }    
-    virtual RNode *M(SpeciesTree *st) { 
-	if (!(computed & C_MAP)) 
+    virtual RNode *M(ReconcileContext &rc) { 
+	if (rc.memo && rc.memo->M[rc.clade[idn]]) return rc.memo->M[rc.clade[idn]];
+	if (!(rc.computed[idn] & C_MAP)) 
 	{
-	    Mn=st->lca(ln->p()->M(st),rn->p()->M(st));
-	    computed|=C_MAP;
+	    // a side without species (-t) is no child
+	    RNode *a=ln->p(rc)->M(rc), *b=rn->p(rc)->M(rc);
+	    rc.Mn[idn] = !a ? b : !b ? a : rc.st->lca(a,b);
+	    rc.computed[idn]|=C_MAP;
 	}
-	return Mn; 	
+	return rc.Mn[idn]; 	
     }  
-    virtual void costdetsubtree(SpeciesTree *st)
+    virtual void costdetsubtree(ReconcileContext &rc)
 	{
-	    dlcostdet(M(st),ln->p()->M(st),rn->p()->M(st));
-	    ln->p()->costdetsubtree(st);
-	    rn->p()->costdetsubtree(st);
+	    dlcostdet(M(rc)->orig(),ln->p(rc)->M(rc)->orig(),rn->p(rc)->M(rc)->orig(),rc.dc);
+	    ln->p(rc)->costdetsubtree(rc);
+	    rn->p(rc)->costdetsubtree(rc);
 	}
-    virtual DlCost& sc(SpeciesTree *st) { 
-	if (!(computed & C_SC)) 
+    virtual DlCost& sc(ReconcileContext &rc) { 
+	if (rc.memo && rc.memo->M[rc.clade[idn]]) return rc.memo->sc[rc.clade[idn]];
+	DlCost &scn = rc.scn[idn];
+	if (!(rc.computed[idn] & C_SC)) 
 	{
-	    scn.loss=ln->p()->sc(st).loss+rn->p()->sc(st).loss
-		+lossprim(M(st),ln->p()->M(st),rn->p()->M(st));
-	    scn.dup=ln->p()->sc(st).dup+rn->p()->sc(st).dup
-		+dupprim(M(st),ln->p()->M(st),rn->p()->M(st));
-	    computed|=C_SC;
+	    UNode *a=ln->p(rc), *b=rn->p(rc);
+	    scn.loss=a->sc(rc).loss+b->sc(rc).loss
+		+lossprim(M(rc),a->M(rc),b->M(rc));
+	    scn.dup=a->sc(rc).dup+b->sc(rc).dup
+		+dupprim(M(rc),a->M(rc),b->M(rc));
+	    rc.computed[idn]|=C_SC;
 	}
 	return scn; 	
     }      
@@ -242,43 +285,58 @@ class UNode3 : public UNode // aha! internal node. "3" because connects to 3 oth
 	// the node's parent.
 	return s;
     }
-    virtual nodset* insert(nodset *n) { 
-	n->insert(this); n->insert(ln); n->insert(rn); 
-	ln->p()->insert(n); rn->p()->insert(n); return n; 
+    virtual nodset* insert(nodset *n, ReconcileContext *rc=NULL) { 
+	n->push_back(this); n->push_back(ln); n->push_back(rn); 
+	ln->p(rc)->insert(n,rc); rn->p(rc)->insert(n,rc); return n; 
     } 
-    virtual RNode* smprooted() { return new RInt(ln->p()->smprooted(), rn->p()->smprooted(), complete_label, strlen(complete_label)); }    
-    virtual ostream& smppf(ostream& s, double c, SpeciesTree *st) {
+    virtual RNode* smprooted(ReconcileContext *rc=NULL) { return new RInt(ln->p(rc)->smprooted(rc), rn->p(rc)->smprooted(rc), complete_label, strlen(complete_label)); }    
+    virtual ostream& smppf(ostream& s, double c, ReconcileContext &rc) {
         s << "( (";
-        ln->p()->smppf(s,c,st) << ") ";
-        ln->pcosts(s,c,st);
+        ln->p(rc)->smppf(s,c,rc) << ") ";
+        ln->pcosts(s,c,rc);
         s << ", ( ";
-        rn->p()->smppf(s,c,st) << " ) " ;
-        rn->pcosts(s,c,st);
+        rn->p(rc)->smppf(s,c,rc) << " ) " ;
+        rn->pcosts(s,c,rc);
         s << " )";
-        pcosts(s,c,st);
+        pcosts(s,c,rc);
         return s;
     }
-    virtual UNode* subtreecost(SpeciesTree *st)
-	{
-	    UNode *res=ln->p()->subtreecost(st);	    
-	    UNode *res1=rn->p()->subtreecost(st);	    	    
-	    if (res->cost(st).mut()>res1->cost(st).mut()) res=res1;
-	    if (res->cost(st).mut()>cost(st).mut()) return this;
-	    return res;
-	}
-
-    virtual UNode* mincost(SpeciesTree *st)
-	{
-	    UNode *res=pn->subtreecost(st);
-	    UNode *res1=ln->p()->subtreecost(st);
-	    if (res->cost(st).mut()>res1->cost(st).mut()) res=res1;
-	    res1=rn->p()->subtreecost(st);
-	    if (res->cost(st).mut()>res1->cost(st).mut()) return res1;
-	    return res;
-	}
 };
 
-class UTree;
+// member templates cannot be virtual, so these dispatch on leaf()
+template<class W> UNode* UNode::subtreecost(ReconcileContext &rc)
+{
+    if (leaf())
+    {
+	cost(rc);
+	return this;
+    }
+    UNode3 *u = (UNode3*)this;
+    UNode *res=u->l()->p(rc)->subtreecost<W>(rc);	    
+    UNode *res1=u->r()->p(rc)->subtreecost<W>(rc);	    	    
+    if (W::mut(res->cost(rc))>W::mut(res1->cost(rc))) res=res1;
+    if (W::mut(res->cost(rc))>W::mut(cost(rc))) return this;
+    return res;
+}
+
+template<class W> UNode* UNode::mincost(ReconcileContext &rc)
+{
+    if (leaf())
+    {
+	cost(rc);
+	if (!p(rc)) return this;
+	if (p(rc)->leaf()) return this;
+	return p(rc)->subtreecost<W>(rc);
+    }
+    UNode3 *u = (UNode3*)this;
+    UNode *res=p(rc)->subtreecost<W>(rc);
+    UNode *res1=u->l()->p(rc)->subtreecost<W>(rc);
+    if (W::mut(res->cost(rc))>W::mut(res1->cost(rc))) res=res1;
+    res1=u->r()->p(rc)->subtreecost<W>(rc);
+    if (W::mut(res->cost(rc))>W::mut(res1->cost(rc))) return res1;
+    return res;
+}
+
 class iterator_utree
 {
  protected:
@@ -291,10 +349,46 @@ class iterator_utree
     UNode *operator()();
 };
 
+// -W: a weight vector for duplications, losses and deep coalescence
+typedef struct Weights
+{
+    double dup, loss, dc;
+} Weights;
+
+// a rooting (the edge above edge) with its duplication, loss and deep
+// coalescence counts
+typedef struct Rooting
+{
+    UNode *edge;
+    int dup, loss, dc;
+    double mut(Weights &w) { return w.dup*dup+w.loss*loss+w.dc*dc; }
+    friend ostream& operator<<(ostream&s, Rooting r)  
+    { return s << "(" << r.dup << "," << r.loss << "," << r.dc << ")"; } 
+} Rooting;
+
+// A multifurcating node of the input. It is parsed as a caterpillar of
+// binary nodes; UTree::resolve rewires them for every species tree, in
+// the ReconcileContext.
+typedef struct Polytomy
+{
+    int pre;               // preorder index of the node in the input
+    int root;              // the root of the input, no edge above
+    int up;                // eid() of the edge above
+    vector<UNode3*> tops;  // the triples, by the node connect() returns
+} Polytomy;
+
 class UTree 
 {
  protected:
     UNode *start;
+    vector<Polytomy> polyv; // innermost first
+    nodset nodev; // all nodes, nodev[i]->id()==i
+    vector<int> cladev; // clade ids of the nodes, see hashcons()
+    void number();
+    int parsed; // preorder counter of parseNode
+    int freeeid; // the next eid() for a new edge
+    vector<int> uppre; // preorder index of the parent of every parsed node, see edgeends()
+    int cladeof(UNode *u, CladeTable &t);
     UNode *toUNodes(RNode *t);
     UNode3* connect(UNode3 *a, UNode3 *b, UNode3 *c, UNode *u1, UNode *u2);
     virtual UNode *createLeaf(char *s, int len=0) { return new ULeaf(xstrndup(s,len)); } 
@@ -305,23 +399,139 @@ class UTree
 			return connect(new UNode3(NULL, s, len),new UNode3(NULL, s, len),new UNode3(NULL, s, len),u1,u2);  }
 
     UNode *parseNode(char *s, int &p, int fromroot=0);
+    UNode *decodeNode(TreeCode &c, int fromroot=0);
+    UNode *internal(nodset &kids, int pre, int fromroot, char *l=NULL, int len=0);
     void initrand(int len,double pint, double dec, char **t, int splen);
+    void resolve(Polytomy &t, ReconcileContext &rc);
+    void editing(ReconcileContext *rc);
+    void addnode(UNode *u, ReconcileContext *rc);
+    void removenode(UNode *u, ReconcileContext *rc);
+    void changed(nodset &self, nodset &next, ReconcileContext *rc);
  public:
-    UTree(char *t) { int p=0; parseNode(t,p,1); }  
+    UTree(char *t) { int p=0; parsed=0; parseNode(t,p,1); endTree(t,p); number(); }  
+    UTree(TreeCode &c) { parsed=0; decodeNode(c,1); number(); }  
     UTree() { start=NULL; }
     UTree(int len,double pint, double dec, SpeciesTree *sp);
     UTree(int len,double pint, double dec, int numlv, int uniquelv, char *t);
-    virtual ~UTree() {}    
+    // random joins of the leaves of g, drawn with rand_r(seed)
+    UTree(UTree *g, unsigned int *seed);
+    virtual ~UTree();
     friend class iterator_utree;    
+    friend class ReconcileContext;
     virtual ostream& pprooted(ostream&s);    
-    nodset* nodes() { return start->insert(start->p()->insert(new nodset)); } 
-    UNode *findoptimaledge(SpeciesTree *st); 
-    void clear() { start->clear(); if (start->p()) start->p()->clear(); } 
-    void pf(ostream &s,SpeciesTree *st) { s << "[" ; start->pf(s,0,st); s << "]" << endl; } 
-    UNode* mincost(SpeciesTree *st) { return start->mincost(st); }
+    nodset* nodes() { return &nodev; } 
+    int size() { return nodev.size(); }
+    UNode *node(int i) { return nodev[i]; }
+    void hashcons(CladeTable &t);
+    int *clades() { return &cladev[0]; }
+    int polytomies() { return polyv.size(); }
+    void resolve(ReconcileContext &rc);
+    // takes out the leaves without a species in rc.st, and their nodes, in
+    // rc; returns the number
+    int prune(ReconcileContext &rc);
+    UNode *findoptimaledge(ReconcileContext &rc); 
+    int spannodes(ReconcileContext &rc);
+    void optimaledges(ReconcileContext &rc, vector<Weights> &w, vector<Rooting> &best);
+    // the id of the edge of u, by which -k and -F name it: u->eid(rc), or,
+    // for an edge prune() joined, the larger eid() of its ends, its lower end
+    int edgeid(UNode *u, ReconcileContext &rc) 
+    { return (u->p(rc) && u->p(rc)->eid(rc)>u->eid(rc)) ? u->p(rc)->eid(rc) : u->eid(rc); }
+    // the ends of the edge above u in input preorder: v is edgeid(u), a is
+    // its parent or, at a binary root, the other child, or the other end of
+    // an edge prune() joined; a==v inside a resolved polytomy v and a==-1 in
+    // generated trees
+    void edgeends(UNode *u, int &a, int &v, ReconcileContext &rc);
+    // the input preorder index of the node of u (its triple, or the leaf);
+    // the triples of a resolved polytomy share it, -1 in generated trees
+    int vertexpre(UNode *u, ReconcileContext &rc);
+    // co-optimal (k==0) or the k cheapest rootings, cheapest first, ties by edgeid()
+    template<class W> void rootings(ReconcileContext &rc, int k, nodset &res);
+    void pf(ostream &s,ReconcileContext &rc) { s << "[" ; rc.start()->pf(s,0,rc); s << "]" << endl; } 
+    template<class W> UNode* mincost(ReconcileContext &rc) { return rc.start()->mincost<W>(rc); }
+    // the shape rc has for its species tree becomes the tree's own
+    void adopt(ReconcileContext *rc);
+    // Edits, see edit.cpp. They return 0, leaving the tree as it is, if the
+    // arguments do not make such an edit. rc (optional) stays valid.
+    int nni(UNode *b, UNode *c, ReconcileContext *rc=NULL);
+    int spr(UNode *s, UNode *e, ReconcileContext *rc=NULL);
+    UNode *insertleaf(char *label, UNode *e, ReconcileContext *rc=NULL);
+    int deleteleaf(UNode *l, ReconcileContext *rc=NULL);
     UNode *genRand(double pint, double dec, char **t, int s);
     virtual ostream& print(ostream&s) { return cout  << *start->rooted(); };    
 
 };
 
+template<class W> struct RootingOrder
+{
+    ReconcileContext &rc;
+    RootingOrder(ReconcileContext &r) : rc(r) {}
+    bool operator()(UNode *a, UNode *b)
+    {
+	typename W::value ca=W::mut(a->cost(rc)), cb=W::mut(b->cost(rc));
+	if (ca!=cb) return ca<cb;
+	return rc.gt->edgeid(a,rc)<rc.gt->edgeid(b,rc);
+    }
+};
+
+// one pass over the edges; each edge is represented by one of its two nodes
+template<class W> void UTree::rootings(ReconcileContext &rc, int k, nodset &res)
+{
+    res.clear();
+    for (size_t i=0; i<nodev.size(); i++)
+    {
+	UNode *u=nodev[i];
+	if (u->p(rc) && u->id()<u->p(rc)->id()) res.push_back(u);
+    }
+    if (res.empty())
+    {
+	res.push_back(rc.start());
+	return;
+    }
+    RootingOrder<W> less(rc);
+    if (k>0)
+    {
+	if (k>(int)res.size()) k=res.size();
+	partial_sort(res.begin(),res.begin()+k,res.end(),less);
+	res.resize(k);
+	return;
+    }
+    typename W::value min=W::mut(res[0]->cost(rc));
+    for (size_t i=1; i<res.size(); i++)
+	if (W::mut(res[i]->cost(rc))<min) min=W::mut(res[i]->cost(rc));
+    size_t n=0;
+    for (size_t i=0; i<res.size(); i++)
+	if (W::mut(res[i]->cost(rc))==min) res[n++]=res[i];
+    res.resize(n);
+    sort(res.begin(),res.end(),less);
+}
+
+typedef vector<UTree*> utreevec;
+
+SpeciesTree *projection(SpeciesTree *s, UTree *g);
+
+// an optimal rooting: its cost and edgeends()
+typedef struct PairCost
+{
+    DlCost cost;
+    int a, v;
+} PairCost;
+
+// The optimal rooting of every gene tree with every species tree (-v, -b),
+// computed by parallel_tiles()
+class PairCosts
+{
+    utreevec &gt;
+    vector<SpeciesTree*> st;
+    vector<CladeMemo*> memo;
+    vector<PairCost> r;
+    int project;
+ public:
+    PairCosts(utreevec &g, vector<SpeciesTree*> s, CladeTable *ct, int pr);
+    ~PairCosts();
+    void operator()(int g, int s, int tid);
+    void run();
+    void runnested(); // gene trees in parallel, each with all species trees; for urecbench
+    PairCost &at(int g, int s) { return r[(size_t)g*st.size()+s]; }
+};
+
 #endif
@@ -0,0 +1,339 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <vector>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+using namespace std;
+
+#include "zstream.h"
+
+#define ZBUFSIZE (1<<16)
+
+#define Z_PLAIN 0
+#define Z_GZIP 1
+#define Z_ZSTD 2
+
+static const unsigned char gzmagic[] = { 0x1f, 0x8b };
+static const unsigned char zstdmagic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+// the state behind a zopen() stream; buf holds compressed bytes, peek
+// the first bytes of the data (zpeek()), read again from peekpos
+struct ZFile
+{
+    FILE *f, *stream;
+    int type, writing, ended;
+    unsigned char buf[ZBUFSIZE];
+    size_t pos, len;
+    vector<char> peek;
+    size_t peekpos;
+    z_stream zs;
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *zd;
+    ZSTD_CStream *zc;
+#endif
+};
+
+// the compressing streams, for zsync(), and the cookie streams read
+static vector<ZFile*> writers, readers;
+
+static int magictype(unsigned char *b, size_t len)
+{
+    if (len>=sizeof(gzmagic) && !memcmp(b,gzmagic,sizeof(gzmagic))) return Z_GZIP;
+    if (len>=sizeof(zstdmagic) && !memcmp(b,zstdmagic,sizeof(zstdmagic))) return Z_ZSTD;
+    return Z_PLAIN;
+}
+
+static void zfail(const char *what)
+{
+    cerr << "Compressed stream: " << what << endl;
+    exit(-1);
+}
+
+// what there is of the next ZBUFSIZE bytes of f, without waiting for the
+// rest as fread() would: a pipe gives what has been written to it
+static size_t zrawread(FILE *f, unsigned char *b, size_t n)
+{
+    ssize_t r;
+    do r=read(fileno(f),b,n);
+    while (r<0 && errno==EINTR);
+    return r>0 ? r : 0;
+}
+
+// refills buf when it is used up; 0 at the end of the file
+static int zfill(ZFile *z)
+{
+    if (z->pos<z->len) return 1;
+    z->pos=0;
+    z->len=zrawread(z->f,z->buf,ZBUFSIZE);
+    return z->len>0;
+}
+
+static ssize_t zdecode(ZFile *z, char *out, size_t n)
+{
+    if (z->type==Z_PLAIN)
+    {
+	if (!zfill(z)) return 0;
+	if (n>z->len-z->pos) n=z->len-z->pos;
+	memcpy(out,z->buf+z->pos,n);
+	z->pos+=n;
+	return n;
+    }
+    size_t done=0;
+    while (!done)
+    {
+	if (!zfill(z))
+	{
+	    if (!z->ended) zfail("unexpected end of file");
+	    return 0;
+	}
+	if (z->type==Z_GZIP)
+	{
+	    // concatenated gzip members are read as one stream
+	    if (z->ended) { inflateReset(&z->zs); z->ended=0; }
+	    z->zs.next_in=z->buf+z->pos;
+	    z->zs.avail_in=z->len-z->pos;
+	    z->zs.next_out=(Bytef*)out;
+	    z->zs.avail_out=n;
+	    int r=inflate(&z->zs,Z_NO_FLUSH);
+	    if (r==Z_STREAM_END) z->ended=1;
+	    else if (r!=Z_OK && r!=Z_BUF_ERROR) zfail("corrupt gzip data");
+	    z->pos=z->len-z->zs.avail_in;
+	    done=n-z->zs.avail_out;
+	}
+#ifdef HAVE_ZSTD
+	else
+	{
+	    ZSTD_inBuffer in = { z->buf, z->len, z->pos };
+	    ZSTD_outBuffer o = { out, n, 0 };
+	    size_t r=ZSTD_decompressStream(z->zd,&o,&in);
+	    if (ZSTD_isError(r)) zfail(ZSTD_getErrorName(r));
+	    z->ended=(r==0);
+	    z->pos=in.pos;
+	    done=o.pos;
+	}
+#endif
+    }
+    return done;
+}
+
+static ssize_t zread(void *c, char *out, size_t n)
+{
+    ZFile *z = (ZFile*)c;
+    if (z->peekpos<z->peek.size())
+    {
+	if (n>z->peek.size()-z->peekpos) n=z->peek.size()-z->peekpos;
+	memcpy(out,&z->peek[z->peekpos],n);
+	z->peekpos+=n;
+	return n;
+    }
+    return zdecode(z,out,n);
+}
+
+// compresses len bytes of data, or finishes the stream if data is NULL
+static void zdeflate(ZFile *z, const char *data, size_t len)
+{
+    if (z->type==Z_GZIP)
+    {
+	z->zs.next_in=(Bytef*)data;
+	z->zs.avail_in=len;
+	int r;
+	do
+	{
+	    z->zs.next_out=z->buf;
+	    z->zs.avail_out=ZBUFSIZE;
+	    r=deflate(&z->zs,data ? Z_NO_FLUSH : Z_FINISH);
+	    if (r==Z_STREAM_ERROR) zfail("gzip error");
+	    if (fwrite(z->buf,1,ZBUFSIZE-z->zs.avail_out,z->f)!=ZBUFSIZE-z->zs.avail_out) zfail("write error");
+	} while (data ? z->zs.avail_in>0 : r!=Z_STREAM_END);
+    }
+#ifdef HAVE_ZSTD
+    else
+    {
+	ZSTD_inBuffer in = { data, len, 0 };
+	size_t r;
+	do
+	{
+	    ZSTD_outBuffer o = { z->buf, ZBUFSIZE, 0 };
+	    r = data ? ZSTD_compressStream(z->zc,&o,&in) : ZSTD_endStream(z->zc,&o);
+	    if (ZSTD_isError(r)) zfail(ZSTD_getErrorName(r));
+	    if (fwrite(z->buf,1,o.pos,z->f)!=o.pos) zfail("write error");
+	} while (data ? in.pos<in.size : r>0);
+    }
+#endif
+}
+
+static ssize_t zwrite(void *c, const char *data, size_t n)
+{
+    zdeflate((ZFile*)c,data,n);
+    return n;
+}
+
+static int zclose(void *c)
+{
+    ZFile *z = (ZFile*)c;
+    if (z->writing) 
+    {
+	zdeflate(z,NULL,0);
+	for (size_t i=0; i<writers.size(); i++)
+	    if (writers[i]==z) { writers.erase(writers.begin()+i); break; }
+    }
+    else
+	for (size_t i=0; i<readers.size(); i++)
+	    if (readers[i]==z) { readers.erase(readers.begin()+i); break; }
+    if (z->type==Z_GZIP)
+    {
+	if (z->writing) deflateEnd(&z->zs);
+	else inflateEnd(&z->zs);
+    }
+#ifdef HAVE_ZSTD
+    if (z->zd) ZSTD_freeDStream(z->zd);
+    if (z->zc) ZSTD_freeCStream(z->zc);
+#endif
+    int r=0;
+    if (z->f==stdout) r=fflush(z->f);
+    else if (z->f!=stdin) r=fclose(z->f);
+    delete z;
+    return r;
+}
+
+static int suffix(const char *fn, const char *s)
+{
+    size_t l=strlen(fn), k=strlen(s);
+    return l>k && !strcmp(fn+l-k,s);
+}
+
+FILE *zopen(const char *fn, const char *mode)
+{
+    int writing = (mode[0]=='w' || mode[0]=='a');
+    int std = !strcmp(fn,"-");
+    FILE *f = std ? (writing ? stdout : stdin) : fopen(fn,writing ? (mode[0]=='a' ? "ab" : "wb") : "rb");
+    if (!f) return NULL;
+
+    ZFile *z = new ZFile;
+    z->f=f;
+    z->writing=writing;
+    z->ended=0;
+    z->pos=z->len=0;
+    z->peekpos=0;
+    memset(&z->zs,0,sizeof(z->zs));
+#ifdef HAVE_ZSTD
+    z->zd=NULL;
+    z->zc=NULL;
+#endif
+    if (writing)
+	z->type = suffix(fn,".gz") ? Z_GZIP : suffix(fn,".zst") ? Z_ZSTD : Z_PLAIN;
+    else
+    {
+	// a pipe may deliver the magic in pieces
+	size_t r;
+	while (z->len<sizeof(zstdmagic) && (r=zrawread(f,z->buf+z->len,ZBUFSIZE-z->len))>0) z->len+=r;
+	z->type = magictype(z->buf,z->len);
+    }
+    // plain files need no cookie; other plain input cannot be rewound, the
+    // cookie gives the bytes read for the magic first
+    struct stat st;
+    if (z->type==Z_PLAIN && (writing || (!std && !fstat(fileno(f),&st) && S_ISREG(st.st_mode))))
+    {
+	if (!writing) rewind(f);
+	delete z;
+	return f;
+    }
+    int r=Z_OK;
+    if (z->type==Z_GZIP)
+	r = writing ? deflateInit2(&z->zs,Z_DEFAULT_COMPRESSION,Z_DEFLATED,15+16,8,Z_DEFAULT_STRATEGY)
+	    : inflateInit2(&z->zs,15+16);
+    if (r!=Z_OK) zfail("zlib initialisation failed");
+    if (z->type==Z_ZSTD)
+    {
+#ifdef HAVE_ZSTD
+	size_t r;
+	if (writing) r=ZSTD_initCStream(z->zc=ZSTD_createCStream(),3);
+	else r=ZSTD_initDStream(z->zd=ZSTD_createDStream());
+	if (ZSTD_isError(r)) zfail(ZSTD_getErrorName(r));
+#else
+	cerr << fn << ": zstd support not compiled in (make ZSTD=1)" << endl;
+	exit(-1);
+#endif
+    }
+    cookie_io_functions_t io = { zread, zwrite, NULL, zclose };
+    z->stream=fopencookie(z,mode,io);
+    if (writing) writers.push_back(z);
+    else readers.push_back(z);
+    return z->stream;
+}
+
+long zsync(FILE *f)
+{
+    if (fflush(f)) return -1;
+    for (size_t i=0; i<writers.size(); i++)
+    {
+	ZFile *z=writers[i];
+	if (z->stream!=f) continue;
+	zdeflate(z,NULL,0);
+	if (z->type==Z_GZIP) deflateReset(&z->zs);
+#ifdef HAVE_ZSTD
+	else ZSTD_initCStream(z->zc,3);
+#endif
+	f=z->f;
+	if (fflush(f)) return -1;
+    }
+    return ftell(f);
+}
+
+static ZFile *reader(FILE *f)
+{
+    for (size_t i=0; i<readers.size(); i++)
+	if (readers[i]->stream==f) return readers[i];
+    return NULL;
+}
+
+size_t zpeek(FILE *f, char *b, size_t n)
+{
+    ZFile *z=reader(f);
+    if (!z)
+    {
+	// a regular file
+	size_t r=fread(b,1,n,f);
+	rewind(f);
+	return r;
+    }
+    ssize_t r=1;
+    while (z->peek.size()<n && r>0)
+    {
+	size_t have=z->peek.size();
+	z->peek.resize(n);
+	r=zdecode(z,&z->peek[have],n-have);
+	z->peek.resize(have+(r>0 ? r : 0));
+    }
+    if (n>z->peek.size()) n=z->peek.size();
+    if (n) memcpy(b,&z->peek[0],n);
+    return n;
+}
+
+int zcompressed(FILE *f)
+{
+    ZFile *z=reader(f);
+    return z && z->type!=Z_PLAIN;
+}
+
+int zstreaming(const char *fn)
+{
+    struct stat st;
+    if (strcmp(fn,"-") ? stat(fn,&st) : fstat(STDIN_FILENO,&st)) return 0;
+    return !S_ISREG(st.st_mode);
+}
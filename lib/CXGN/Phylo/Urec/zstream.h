@@ -0,0 +1,52 @@
+/************************************************************************
+   Unrooted REConciliation version 1.00
+   (c) Copyright 2005-2006 by Pawel Gorecki
+   Written by P.Gorecki.
+   Permission is granted to copy and use this program provided no fee is
+   charged for it and provided that this copyright notice is not removed.
+*************************************************************************/
+
+#ifndef _ZSTREAM__
+#define _ZSTREAM__
+
+#include <stdio.h>
+#include <streambuf>
+using namespace std;
+
+// Compressed files as stdio streams, (de)compressed while they are read
+// or written. Reading recognises gzip and (built with HAVE_ZSTD) zstd data
+// by its first bytes, anything else is read as it is. Writing ("w", or
+// "a" to append) compresses by the suffix of the name, .gz or .zst. "-"
+// is stdin or stdout. fclose() finishes the compressed stream.
+FILE *zopen(const char *fn, const char *mode);
+
+// flushes a written stream up to a point where the file can be cut and
+// appended to (a new gzip member or zstd frame); returns the file size
+// then, or -1 if it is not a regular file
+long zsync(FILE *f);
+
+// the first n bytes of a stream zopen() has opened for reading, before
+// anything else is read from it; they are read again after. Returns how
+// many there are. Pipes are not opened twice to look at their start.
+size_t zpeek(FILE *f, char *b, size_t n);
+
+// 1 if f, opened by zopen() for reading, is decompressed
+int zcompressed(FILE *f);
+
+// 1 if fn ("-" for stdin) is a pipe, terminal or socket rather than a
+// file, so its data come as they are written
+int zstreaming(const char *fn);
+
+// cout.rdbuf() over a zopen()ed stream (-w)
+class zfilebuf : public streambuf
+{
+    FILE *f;
+ protected:
+    virtual int overflow(int c) { return (c==EOF || fputc(c,f)!=EOF) ? (c==EOF ? 0 : c) : EOF; }
+    virtual streamsize xsputn(const char *s, streamsize n) { return fwrite(s,1,n,f); }
+    virtual int sync() { return fflush(f); }
+ public:
+    zfilebuf(FILE *f_) : f(f_) {}
+};
+
+#endif
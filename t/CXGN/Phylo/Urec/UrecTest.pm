@@ -0,0 +1,79 @@
+package UrecTest;
+
+# Shared by the tests of the urec engine: finds the binaries under test
+# (lib/CXGN/Phylo/Urec, or $ENV{UREC}) and runs them without a shell.
+
+use strict;
+use warnings;
+use FindBin;
+use File::Spec;
+use File::Temp qw/tempfile/;
+use IPC::Open3;
+use Symbol qw/gensym/;
+use Exporter 'import';
+
+our @EXPORT = qw/urec_tool urec_has urec run data_file/;
+
+my $dir = $ENV{UREC}
+    ? (File::Spec->splitpath(File::Spec->rel2abs($ENV{UREC})))[1]
+    : File::Spec->catdir($FindBin::RealBin, qw/.. .. .. .. lib CXGN Phylo Urec/);
+
+# urec, urecdist or urec-merge
+sub urec_tool {
+    my ($name) = @_;
+    return $ENV{UREC} if $ENV{UREC} && $name eq 'urec';
+    return File::Spec->catfile($dir, $name);
+}
+
+# 1 if the urec there is built and lists all the given options in its usage
+sub urec_has {
+    my $urec = urec_tool('urec');
+    return 0 unless -x $urec;
+    my ($usage) = run($urec);
+    foreach my $opt (@_) {
+        return 0 unless $usage =~ /^\s*\Q$opt\E\b/m;
+    }
+    return 1;
+}
+
+# stdout, stderr and exit status of a command; a last argument that is a
+# reference to a string is its stdin
+sub run {
+    my @cmd = @_;
+    my ($ifh, $efh);
+    if (@cmd && ref $cmd[-1] eq 'SCALAR') {
+        my $input = ${pop @cmd};
+        $ifh = tempfile(UNLINK => 1);
+        print $ifh $input;
+        seek $ifh, 0, 0;
+    }
+    else {
+        open $ifh, '<', File::Spec->devnull() or die $!;
+    }
+    $efh = tempfile(UNLINK => 1);
+    my $out = gensym;
+    my $pid = eval { open3('<&' . fileno($ifh), $out, '>&' . fileno($efh), @cmd) };
+    return ('', $@, 255) unless $pid; # not runnable here
+    # a run that hangs (a pipe read twice) is killed
+    local $SIG{ALRM} = sub { kill 'KILL', $pid };
+    alarm 60;
+    my $stdout = do { local $/; <$out> };
+    waitpid($pid, 0);
+    alarm 0;
+    my $status = $? >> 8;
+    seek $efh, 0, 0;
+    my $stderr = do { local $/; <$efh> };
+    return ($stdout // '', $stderr // '', $status);
+}
+
+# urec with the arguments, its stdout
+sub urec {
+    my ($stdout) = run(urec_tool('urec'), @_);
+    return $stdout;
+}
+
+sub data_file {
+    return File::Spec->catfile($FindBin::RealBin, 'data', @_);
+}
+
+1;
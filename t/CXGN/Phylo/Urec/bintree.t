@@ -0,0 +1,61 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -T converts -G and -S files to the binary format, which reads back as the
+# same trees; a damaged binary file is an error, not a crash
+plan skip_all => "no urec with -T built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-T');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+my $species = data_file('species.txt');
+
+sub slurp {
+    my ($fn) = @_;
+    open my $fh, '<', $fn or die "$fn: $!";
+    binmode $fh;
+    local $/;
+    return <$fh>;
+}
+
+sub spew {
+    my ($fn, $data) = @_;
+    open my $fh, '>', $fn or die "$fn: $!";
+    binmode $fh;
+    print $fh $data;
+    close $fh;
+}
+
+my ($out, $err, $status) = run($urec, '-T', "$dir/species.bin", '-S', $species);
+is($status, 0, "-T -S");
+like($err . $out, qr/3 trees written/, "-T -S writes the species trees");
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my $bin = "$dir/$genes.bin";
+    ($out, $err, $status) = run($urec, '-T', $bin, '-G', data_file($genes));
+    is($status, 0, "-T -G $genes");
+    foreach my $opts (['-p'], ['-b', '-k', 0], ['-b', '-F', 'tsv'], ['-b', '-x']) {
+        is(urec('-S', "$dir/species.bin", '-G', $bin, @$opts), urec('-S', $species, '-G', data_file($genes), @$opts),
+           "$genes @$opts from the binary files");
+    }
+}
+
+# every truncation after the magic, and a byte too many
+foreach my $bin ("$dir/species.bin", "$dir/poly.txt.bin") {
+    my $data = slurp($bin);
+    my $bad = 0;
+    foreach my $len (5 .. length($data) - 1, -1) {
+        spew("$dir/bad.bin", $len < 0 ? "$data\0" : substr($data, 0, $len));
+        my @args = $bin =~ /species/ ? ('-S', "$dir/bad.bin", '-g', '(a,b,c);') : ('-S', $species, '-G', "$dir/bad.bin");
+        ($out, $err, $status) = run($urec, @args, '-b', '-c');
+        $bad++ unless $status && $err =~ /^\Q$dir\E\/bad\.bin: bad binary tree file$/m;
+    }
+    is($bad, 0, "damaged $bin files are rejected");
+}
+
+done_testing();
@@ -0,0 +1,74 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Spec;
+use File::Temp qw/tempdir/;
+use IO::Uncompress::Gunzip qw/gunzip $GunzipError/;
+use Time::HiRes qw/sleep/;
+use POSIX ();
+
+use UrecTest;
+
+# a -K run killed after a checkpoint and resumed with -U gives the output
+# of a run that was never stopped
+plan skip_all => "no urec with -K and -U built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-K', '-U');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+my $species = data_file('species.txt');
+
+# enough gene trees for a run of some seconds with a checkpoint after each
+open my $in, '<', data_file('genes.txt') or die $!;
+my $genes = do { local $/; <$in> };
+open my $out, '>', "$dir/genes.txt" or die $!;
+print $out $genes x 100;
+close $out;
+
+sub slurp {
+    my ($fn) = @_;
+    if ($fn =~ /\.gz$/) {
+        # a resumed run appends a gzip member
+        gunzip($fn => \my $data, MultiStream => 1) or die $GunzipError;
+        return $data;
+    }
+    open my $fh, '<', $fn or die "$fn: $!";
+    local $/;
+    return <$fh>;
+}
+
+# urec with @args, killed some time after the first checkpoint
+sub interrupted {
+    my ($ck, @args) = @_;
+    my $pid = fork();
+    die "fork: $!" unless defined $pid;
+    if (!$pid) {
+        open STDOUT, '>', File::Spec->devnull();
+        exec($urec, @args) or POSIX::_exit(1);
+    }
+    my $t = 0;
+    sleep(0.05), $t++ until -s $ck || $t > 600;
+    sleep 0.5;
+    kill 'KILL', $pid;
+    waitpid($pid, 0);
+}
+
+foreach my $name ('out.txt', 'out.gz') {
+    my @args = ('-S', $species, '-G', "$dir/genes.txt", '-b', '-F', 'tsv', '-c');
+    my $expected = urec(@args);
+    unlink "$dir/ck";
+    interrupted("$dir/ck", @args, '-K', "$dir/ck,0", '-w', "$dir/$name");
+    ok(-s "$dir/ck", "$name: checkpoint written");
+    ok(slurp("$dir/$name") ne $expected, "$name: the run was stopped");
+    # a checkpoint is for the trees and options it was made with
+    my (undef, $err, $status) = run($urec, '-S', $species, '-G', data_file('genes.txt'), '-b', '-F', 'tsv', '-c',
+                                    '-K', "$dir/ck,0", '-U');
+    ok($status && $err =~ /belongs to another run/, "$name: a checkpoint of other gene trees is refused");
+    ($err, $status) = (run($urec, @args, '-K', "$dir/ck,0", '-U', '-w', "$dir/$name"))[1, 2];
+    is($status, 0, "$name: resumed") or diag($err);
+    ok(slurp("$dir/$name") eq $expected, "$name: the resumed run wrote it all");
+}
+
+done_testing();
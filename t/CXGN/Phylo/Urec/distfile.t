@@ -0,0 +1,40 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -Z writes the distributions of -d, binary or tsv, possibly compressed;
+# urecdist prints them back as records or, with -S, as -d and -x do
+plan skip_all => "no urec with -Z and urecdist built in lib/CXGN/Phylo/Urec (or \$UREC)"
+    unless urec_has('-Z') && -x urec_tool('urecdist');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urecdist = urec_tool('urecdist');
+my $species = data_file('species.txt');
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    my $d = urec(@args, '-d');
+    my $x = urec(@args, '-x');
+    my $records;
+    foreach my $name ('dist.bin', 'dist.tsv', 'dist.tsv.gz') {
+        my ($out, $err, $status) = run(urec_tool('urec'), @args, '-Z', "$dir/$name");
+        is($status, 0, "$genes -Z $name") or diag($err);
+        my $r = (run($urecdist, "$dir/$name"))[0];
+        $records //= $r;
+        is($r, $records, "$genes $name: the same records");
+        is((run($urecdist, '-S', $species, "$dir/$name"))[0], $d, "$genes $name: urecdist -S prints -d");
+        is((run($urecdist, '-S', $species, '-x', "$dir/$name"))[0], $x, "$genes $name: urecdist -S -x prints -x");
+    }
+    like($records, qr/^0\t0\t\d+\t\d+$/m, "$genes: records of species, node, dup, loss");
+    unlike($records, qr/\t0\t0$/m, "$genes: only nonzero nodes");
+    open my $fh, '<', "$dir/dist.tsv" or die $!;
+    is(do { local $/; <$fh> }, $records, "$genes: the tsv file has the records");
+}
+
+done_testing();
@@ -0,0 +1,235 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -Y edits a gene tree and shows the optimal rooting after every edit; the
+# costs must be those of the edited tree reconciled from scratch. The edits
+# are made here too, on a tree of nodes and numbered edges.
+plan skip_all => "no urec with -Y built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-Y');
+
+my $dir = tempdir(CLEANUP => 1);
+my $species = do { open my $fh, '<', data_file('species.txt') or die $!; scalar <$fh> };
+chomp $species;
+my @leafspecies = $species =~ /([a-z]+)/g;
+
+# a tree: {adj => {node => {node => edge id}}, label => {leaf => label},
+# free => next edge id}; edges made by an edit whose id depends on
+# urec's node order are undef and not used again
+sub parse {
+    my ($newick) = @_;
+    my %t = (adj => {}, label => {});
+    my (@stack, $last, $n);
+    $n = 0;
+    foreach my $tok ($newick =~ /([(),;]|[^(),;\s]+)/g) {
+        if ($tok eq '(' || ($tok !~ /^[(),;]$/ && $last ne ')')) {
+            my $v = $n++;
+            if (@stack) {
+                $t{adj}{$v}{$stack[-1]} = $t{adj}{$stack[-1]}{$v} = $v;
+            }
+            if ($tok eq '(') { push @stack, $v } else { $t{label}{$v} = $tok }
+        }
+        elsif ($tok eq ')') {
+            pop @stack;
+        }
+        $last = $tok;
+    }
+    $t{free} = $n;
+    return \%t;
+}
+
+sub join_ {
+    my ($t, $a, $b, $e) = @_;
+    $t->{adj}{$a}{$b} = $t->{adj}{$b}{$a} = $e;
+}
+
+sub cut {
+    my ($t, $a, $b) = @_;
+    delete $t->{adj}{$a}{$b};
+    delete $t->{adj}{$b}{$a};
+}
+
+# the ends of the edge with the id
+sub ends {
+    my ($t, $e) = @_;
+    foreach my $a (keys %{$t->{adj}}) {
+        foreach my $b (keys %{$t->{adj}{$a}}) {
+            my $id = $t->{adj}{$a}{$b};
+            return ($a, $b) if defined $id && $id == $e && $a < $b;
+        }
+    }
+    return;
+}
+
+sub edges {
+    my ($t) = @_;
+    my %e;
+    foreach my $a (keys %{$t->{adj}}) {
+        defined && ($e{$_} = 1) foreach values %{$t->{adj}{$a}};
+    }
+    return sort { $a <=> $b } keys %e;
+}
+
+sub degree { return scalar keys %{$_[0]{adj}{$_[1]}} }
+
+# the nodes on b's side of the edge a-b
+sub side {
+    my ($t, $a, $b) = @_;
+    my %seen = ($a => 1, $b => 1);
+    my @todo = ($b);
+    while (@todo) {
+        my $x = pop @todo;
+        foreach (keys %{$t->{adj}{$x}}) { push @todo, $_ unless $seen{$_}++ }
+    }
+    delete $seen{$a};
+    return \%seen;
+}
+
+sub newick {
+    my ($t) = @_;
+    my ($top) = grep { degree($t, $_) == 3 } sort { $a <=> $b } keys %{$t->{adj}};
+    my $write;
+    $write = sub {
+        my ($v, $from) = @_;
+        return $t->{label}{$v} if exists $t->{label}{$v};
+        return '(' . join(',', map { $write->($_, $v) } grep { !defined $from || $_ != $from }
+                          sort { $a <=> $b } keys %{$t->{adj}{$v}}) . ')';
+    };
+    return $write->($top) . ';';
+}
+
+sub nni {
+    my ($t, $eb, $ec) = @_;
+    my @b = ends($t, $eb);
+    my @c = ends($t, $ec);
+    return unless @b && @c;
+    foreach my $x (@b) {
+        foreach my $y (@c) {
+            next if $x == $y || !exists $t->{adj}{$x}{$y} || degree($t, $x) != 3 || degree($t, $y) != 3;
+            my ($bn) = grep { $_ != $x } @b;
+            my ($cn) = grep { $_ != $y } @c;
+            next if $bn == $y || $cn == $x;
+            cut($t, $x, $bn);
+            cut($t, $y, $cn);
+            join_($t, $x, $cn, $ec);
+            join_($t, $y, $bn, $eb);
+            return 1;
+        }
+    }
+    return;
+}
+
+# the subtree at the edge a on the side without the edge f, with the node
+# at its top, onto f
+sub spr {
+    my ($t, $ea, $ef) = @_;
+    my @a = ends($t, $ea);
+    my @f = ends($t, $ef);
+    return unless @a && @f;
+    foreach my $q (@a) {
+        my ($s) = grep { $_ != $q } @a;
+        my $side = side($t, $q, $s);
+        next if $side->{$f[0]} || $side->{$f[1]} || degree($t, $q) != 3;
+        next if grep { $_ == $q } @f;
+        my ($p1, $p2) = grep { $_ != $s } keys %{$t->{adj}{$q}};
+        cut($t, $q, $p1);
+        cut($t, $q, $p2);
+        join_($t, $p1, $p2, undef);
+        cut($t, @f);
+        join_($t, $q, $f[0], undef);
+        join_($t, $q, $f[1], undef);
+        return 1;
+    }
+    return;
+}
+
+sub ins {
+    my ($t, $e, $label) = @_;
+    my @e = ends($t, $e) or return;
+    my $n = 1 + (sort { $b <=> $a } keys %{$t->{adj}})[0];
+    cut($t, @e);
+    join_($t, $n, $e[0], undef);
+    join_($t, $n, $e[1], undef);
+    join_($t, $n, $n + 1, $t->{free} + 1);
+    $t->{label}{$n + 1} = $label;
+    $t->{free} += 2;
+    return 1;
+}
+
+sub del {
+    my ($t, $e) = @_;
+    my @e = ends($t, $e) or return;
+    my ($l) = grep { exists $t->{label}{$_} } @e;
+    return unless defined $l;
+    my ($c) = grep { $_ != $l } @e;
+    return unless degree($t, $c) == 3;
+    my ($p1, $p2) = grep { $_ != $l } keys %{$t->{adj}{$c}};
+    cut($t, $c, $_) foreach ($l, $p1, $p2);
+    delete $t->{adj}{$_} foreach ($l, $c);
+    delete $t->{label}{$l};
+    join_($t, $p1, $p2, undef);
+    return 1;
+}
+
+srand(20061);
+open my $fh, '<', data_file('genes.txt') or die $!;
+# the largest ones, rooted at a node of three edges like all unrooted trees
+my @genes = sort { length $b <=> length $a } grep { degree(parse($_), 0) == 3 } <$fh>;
+my $ins = 0;
+my $n = 0;
+foreach my $gene (@genes[0 .. 9]) {
+    chomp $gene;
+    my $t = parse($gene);
+    my (@script, @trees);
+    for (my $try = 0; @script < 12 && $try < 1000; $try++) {
+        my @e = edges($t) or last;
+        my $leaves = keys %{$t->{label}};
+        my $op = (qw/nni spr ins del/)[int rand 4];
+        $op = 'ins' if $op eq 'del' && $leaves < 5;
+        my ($e1, $e2) = map { $e[int rand @e] } 1 .. 2;
+        my $edit;
+        if ($op eq 'nni') {
+            # an edge across an internal edge from e1
+            my @across;
+            foreach my $x (ends($t, $e1)) {
+                foreach my $y (sort { $a <=> $b } keys %{$t->{adj}{$x}}) {
+                    next if defined $t->{adj}{$x}{$y} && $t->{adj}{$x}{$y} == $e1;
+                    push @across, grep { defined && $_ != $e1 } map { $t->{adj}{$y}{$_} } grep { $_ != $x } sort { $a <=> $b } keys %{$t->{adj}{$y}};
+                }
+            }
+            $e2 = $across[int rand @across] if @across;
+            $edit = "nni $e1 $e2" if nni($t, $e1, $e2);
+        }
+        elsif ($op eq 'spr') { $edit = "spr $e1 $e2" if spr($t, $e1, $e2) }
+        elsif ($op eq 'del') { $edit = "del $e1" if del($t, $e1) }
+        else {
+            my $label = sprintf('x%d[species=%s]', $ins++, $leafspecies[int rand @leafspecies]);
+            $edit = "ins $e1 $label" if ins($t, $e1, $label);
+        }
+        next unless $edit;
+        push @script, $edit;
+        push @trees, newick($t);
+    }
+    open my $out, '>', "$dir/edits" or die $!;
+    print $out map { "$_\n" } @script;
+    close $out;
+    open $out, '>', "$dir/trees" or die $!;
+    print $out map { "$_\n" } $gene, @trees;
+    close $out;
+
+    my ($shown, $err, $status) = run(urec_tool('urec'), '-s', $species, '-g', $gene, '-Y', "$dir/edits");
+    ok(@script >= 8, "gene tree $n: " . @script . " edits");
+    is($status, 0, "gene tree $n: all the edits made") or diag($err);
+    my @shown = map { /^\d+(\(\d+,\d+\))$/ ? $1 : $_ } split /\n/, $shown;
+    my @again = map { /^(\(\d+,\d+\))/ ? $1 : $_ } split /\n/, urec('-s', $species, '-G', "$dir/trees", '-b', '-o');
+    is_deeply(\@shown, \@again, "gene tree $n: the costs of the edited trees")
+        or diag(join("\n", @script));
+    $n++;
+}
+
+done_testing();
@@ -0,0 +1,100 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use JSON::PP;
+
+use UrecTest;
+
+# -V: a record per node of the optimally rooted gene tree, in its preorder:
+# species, gene, weights, node, mapping, dup. The mappings must be lcas,
+# the duplications those of the mappings, and together they must give the
+# dup and loss of -F.
+plan skip_all => "no urec with -V built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-V');
+
+my $species = data_file('species.txt');
+
+# nodes of a newick tree in preorder: [parent, label or undef, depth]
+sub nodes {
+    my ($newick) = @_;
+    my (@n, @stack, $last);
+    foreach my $t ($newick =~ /([(),;]|[^(),;\s]+)/g) {
+        if ($t eq '(') {
+            push @n, [@stack ? $stack[-1] : -1, undef, scalar @stack];
+            push @stack, $#n;
+        }
+        elsif ($t eq ')') {
+            pop @stack;
+        }
+        elsif ($t ne ',' && $t ne ';' && $last ne ')') {
+            my $label = $t =~ /\[species=([^\]]*)\]/ ? $1 : $t;
+            push @n, [$stack[-1], $label, scalar @stack];
+        }
+        $last = $t;
+    }
+    return \@n;
+}
+
+sub lca {
+    my ($s, $a, $b) = @_;
+    my %up;
+    for (my $x = $a; $x >= 0; $x = $s->[$x][0]) { $up{$x} = 1 }
+    for (my $x = $b; $x >= 0; $x = $s->[$x][0]) { return $x if $up{$x} }
+    return -1;
+}
+
+open my $fh, '<', $species or die $!;
+my @st = map { nodes($_) } <$fh>;
+my @leafof = map { my $s = $_; +{ map { defined $s->[$_][1] ? ($s->[$_][1] => $_) : () } 0 .. $#$s } } @st;
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    open $fh, '<', data_file($genes) or die $!;
+    my @gt = map { nodes($_) } <$fh>;
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    my %f = map { my @r = split /\t/; ("$r[0] $r[1]" => [@r[5, 6]]) } split /\n/, urec(@args, '-F', 'tsv');
+    my $tsv = urec(@args, '-V');
+    my %pairs;
+    push @{$pairs{"$_->[0] $_->[1]"}}, $_ foreach map { [split /\t/] } split /\n/, $tsv;
+    is(scalar keys %pairs, scalar(@gt) * @st, "$genes: records of every pair");
+
+    my @json = grep { exists $_->{node} } map { decode_json($_) } split /\n/, urec(@args, '-V', '-F', 'json');
+    is_deeply([map { [@$_{qw/species gene weights node mapping dup/}] } @json], [map { [split /\t/] } split /\n/, $tsv],
+              "$genes: the json records are the tsv ones");
+
+    my $bad = 0;
+    foreach my $pair (sort keys %pairs) {
+        my ($si, $gi) = split / /, $pair;
+        my ($s, $g, $recs) = ($st[$si], $gt[$gi], $pairs{$pair});
+        my ($i, $dup, $loss, $ok, %seen) = (0, 0, 0, 1);
+        # the subtree at the next record: its mapping; adds up dup and loss
+        my $walk;
+        $walk = sub {
+            my $r = $recs->[$i++] or return $ok = 0;
+            my (undef, undef, undef, $node, $m, $d) = @$r;
+            $ok = 0 if $node >= 0 && $seen{$node}++;
+            if ($node >= 0 && defined $g->[$node][1]) {
+                $ok = 0 unless $m == $leafof[$si]{$g->[$node][1]} && $d == 0;
+                return $m;
+            }
+            my @c = ($walk->(), $walk->());
+            return -1 unless $ok;
+            my $lca = lca($s, @c);
+            my $isdup = ($lca == $c[0] || $lca == $c[1]) ? 1 : 0;
+            $ok = 0 unless $m == $lca && $d == $isdup;
+            $dup += $isdup;
+            $loss += $s->[$_][2] - $s->[$lca][2] - 1 + $isdup foreach @c;
+            return $m;
+        };
+        $walk->();
+        # every node of the input once, but a root of two children, which
+        # is no node of the unrooted tree
+        my $n = @$g - (2 == grep { $_->[0] == 0 } @$g);
+        $ok = 0 unless $i == @$recs && keys %seen == $n && $dup == $f{$pair}[0] && $loss == $f{$pair}[1];
+        $bad++, diag("species $si, gene $gi") unless $ok;
+    }
+    is($bad, 0, "$genes: mappings, duplications and losses of every pair");
+}
+
+done_testing();
@@ -0,0 +1,85 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -f: every tree of a family votes for the bipartitions of its optimal
+# rootings, co-optimal ones sharing the vote
+plan skip_all => "no urec with -f built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-f');
+
+my $dir = tempdir(CLEANUP => 1);
+my $species = data_file('species.txt');
+open my $fh, '<', $species or die $!;
+chomp(my @species = <$fh>);
+open $fh, '<', data_file('genes.txt') or die $!;
+chomp(my @genes = <$fh>);
+
+# the leaf names under every node of a newick tree, in preorder
+sub below {
+    my ($newick) = @_;
+    my (@below, @stack, $last);
+    foreach my $t ($newick =~ /([(),;]|[^(),;\s]+)/g) {
+        if ($t eq '(') {
+            push @below, [];
+            push @stack, $#below;
+        }
+        elsif ($t eq ')') {
+            pop @stack;
+        }
+        elsif ($t ne ',' && $t ne ';' && $last ne ')') {
+            (my $name = $t) =~ s/[\[:].*//;
+            push @below, [$name];
+            push @{$below[$_]}, $name foreach @stack;
+        }
+        $last = $t;
+    }
+    return \@below;
+}
+
+# families of three copies of a tree: each copy gives the -k 0 rootings
+# 1/m of a vote
+my $copies = 3;
+open my $out, '>', "$dir/families.txt" or die $!;
+foreach my $i (0 .. 9) {
+    print $out "fam$i $genes[$i]\n" x $copies;
+}
+close $out;
+
+my %got;
+foreach (split /\n/, urec('-S', $species, '-f', "$dir/families.txt", '-b')) {
+    my ($s, $fam, $count, $freq, $side) = split /\t/;
+    $got{$s}{$fam}{$side} = [$count, $freq];
+}
+is(scalar keys %got, scalar @species, "every species tree");
+
+foreach my $s (0 .. $#species) {
+    my @k = split /\n/, urec('-s', $species[$s], '-G', data_file('genes.txt'), '-b', '-k', 0);
+    foreach my $i (0 .. 9) {
+        my $below = below($genes[$i]);
+        my @all = sort @{$below->[0]};
+        my @edges = map { /^(\d+)/ } split / /, $k[$i];
+        my %expected;
+        foreach my $v (@edges) {
+            my %in = map { $_ => 1 } @{$below->[$v]};
+            my @side = grep { $in{$all[0]} ? !$in{$_} : $in{$_} } @all;
+            $expected{join(',', @side)} += $copies / @edges;
+        }
+        my $fam = $got{$s}{"fam$i"} || {};
+        my ($sum, $ok) = (0, 1);
+        foreach my $side (keys %$fam) {
+            my ($count, $freq) = @{$fam->{$side}};
+            $sum += $count;
+            $ok = 0 unless abs($count - ($expected{$side} || 0)) < 1e-4 && abs($freq - $count / $copies) < 1e-4;
+        }
+        $ok = 0 unless keys %$fam == keys %expected;
+        ok($ok, "species tree $s, family $i: the votes of the -k 0 rootings");
+        ok(abs($sum - $copies) < 1e-4, "species tree $s, family $i: a vote per tree");
+    }
+}
+
+done_testing();
@@ -0,0 +1,26 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+
+use UrecTest;
+
+# -H shares the mappings of identical gene subtrees; it must not change
+# any cost or rooting
+plan skip_all => "no urec with -H built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-H');
+
+my $species = data_file('species.txt');
+foreach my $genes ('genes.txt', 'poly.txt') {
+    foreach my $opts (['-F', 'tsv'], ['-c'], ['-C'], ['-d'], ['-k', 0], ['-v']) {
+        my @args = ('-S', $species, '-G', data_file($genes), '-b', @$opts);
+        my $expected = urec(@args);
+        isnt($expected, '', "$genes @$opts");
+        my ($out, $err) = run(urec_tool('urec'), '-H', @args);
+        is($out, $expected, "$genes -H @$opts");
+        like($err, qr/^Clades: \d+ distinct of \d+ subtrees/m, "$genes -H @$opts shares clades");
+    }
+}
+
+done_testing();
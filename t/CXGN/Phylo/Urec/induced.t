@@ -0,0 +1,39 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -I reconciles with the species subtree induced by the gene tree's
+# species; costs, rootings and distributions stay those of the full tree
+plan skip_all => "no urec with -I built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-I');
+
+my $dir = tempdir(CLEANUP => 1);
+
+# the species trees, each with a caterpillar of species no gene tree has
+my $tail = 'z0';
+$tail = "(z$_,$tail)" foreach (1 .. 50);
+open my $in, '<', data_file('species.txt') or die $!;
+open my $out, '>', "$dir/species.txt" or die $!;
+while (<$in>) {
+    s/;\s*$//;
+    print $out "($_,$tail);\n";
+}
+close $out;
+
+foreach my $species (data_file('species.txt'), "$dir/species.txt") {
+    foreach my $genes ('genes.txt', 'poly.txt') {
+        foreach my $opts (['-F', 'tsv'], ['-c'], ['-C'], ['-x'], ['-k', 0], ['-v']) {
+            my @args = ('-S', $species, '-G', data_file($genes), '-b', @$opts);
+            my $expected = urec(@args);
+            isnt($expected, '', "$genes @$opts");
+            is(urec('-I', @args), $expected, "$genes -I @$opts");
+        }
+    }
+}
+
+done_testing();
@@ -0,0 +1,47 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+use IO::Uncompress::Gunzip qw/gunzip $GunzipError/;
+
+use UrecTest;
+
+# -M: the header of matrix.h, then int32 dup, loss of every pair of gene
+# tree and species tree, row by row of gene trees
+plan skip_all => "no urec with -M built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-M');
+
+my $dir = tempdir(CLEANUP => 1);
+my $species = data_file('species.txt');
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    my ($out, $err, $status) = run(urec_tool('urec'), @args, '-M', "$dir/matrix");
+    is($status, 0, "$genes -M") or diag($err);
+    open my $fh, '<', "$dir/matrix" or die $!;
+    binmode $fh;
+    my $data = do { local $/; <$fh> };
+    my ($magic, $g, $s) = unpack('a8 l l', $data);
+    is($magic, "URECMAT\1", "$genes: magic");
+    is($s, 3, "$genes: species trees");
+    is(length($data), 16 + 8 * $g * $s, "$genes: size");
+    my @m = unpack('l*', substr($data, 16));
+
+    # -F tsv: species, gene, weights, u, v, dup, loss
+    my %cost;
+    foreach (split /\n/, urec(@args, '-F', 'tsv')) {
+        my @f = split /\t/;
+        $cost{"$f[1] $f[0]"} = "$f[5] $f[6]";
+    }
+    is(scalar keys %cost, $g * $s, "$genes: a pair for every cell");
+    my $bad = grep { my ($i, $j) = split / /; "$m[2 * ($i * $s + $j)] $m[2 * ($i * $s + $j) + 1]" ne $cost{$_} } keys %cost;
+    is($bad, 0, "$genes: the cells are the costs of -F tsv");
+
+    run(urec_tool('urec'), @args, '-M', "$dir/matrix.gz");
+    gunzip("$dir/matrix.gz" => \my $z) or die $GunzipError;
+    ok($z eq $data, "$genes: -M matrix.gz");
+}
+
+done_testing();
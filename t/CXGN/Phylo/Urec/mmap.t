@@ -0,0 +1,44 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# a -G file of 1 MB or more is mapped and parsed in chunks by all threads;
+# it must give the trees of the line by line reader, in the same order
+plan skip_all => "no urec with -G built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-G');
+
+my $dir = tempdir(CLEANUP => 1);
+my $species = data_file('species.txt');
+my $genes = do { open my $fh, '<', data_file('genes.txt') or die $!; local $/; <$fh> };
+
+# numbered copies of the gene trees, with a blank line in between and no
+# newline at the end
+my @trees = split /\n/, $genes;
+my $big = '';
+my $n = 0;
+while (length $big < 1.5 * (1 << 20)) {
+    foreach my $tree (@trees) {
+        (my $t = $tree) =~ s/\bg(\d+)\[/g${n}_$1\[/g;
+        $big .= "$t\n";
+    }
+    $big .= "\n";
+    $n++;
+}
+chomp $big;
+open my $fh, '>', "$dir/big.txt" or die $!;
+print $fh $big;
+close $fh;
+
+my @report = ('-S', $species, '-b', '-F', 'tsv');
+my $expected = urec(@report, '-G', '-', '-j', 1, \$big);
+is(scalar(() = $expected =~ /\n/g), 3 * @trees * $n, "every tree read from standard input");
+foreach my $threads (1, 3) {
+    is(urec(@report, '-G', "$dir/big.txt", '-j', $threads), $expected, "mapped file with $threads threads");
+}
+
+done_testing();
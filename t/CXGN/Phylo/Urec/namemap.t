@@ -0,0 +1,62 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -m: the species of the leaves of the trees read after it are put in the
+# standard format of CXGN::Phylo::Species_name_map and mapped
+plan skip_all => "no urec with -m built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-m');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+my $species = data_file('species.txt');
+
+# the species a..h of the gene trees as variants of two map files
+open my $m1, '>', "$dir/map1" or die $!;
+print $m1 "(", join(",\n ", map { "variety $_ => species_$_" } 'a' .. 'd'), ")\n";
+close $m1;
+open my $m2, '>', "$dir/map2" or die $!;
+print $m2 map { "Variety $_  =>  Species $_\n" } 'e' .. 'h';
+close $m2;
+
+open my $in, '<', data_file('genes.txt') or die $!;
+open my $out, '>', "$dir/genes.txt" or die $!;
+my $n = 0;
+while (<$in>) {
+    # the map, the standard name in other spellings, or the species itself
+    s/\[species=(\w)\]/'[species=' . ('VARIETY_', 'variety ', 'Species_', 'SPECIES ', 'species_')[$n++ % 5] . "$1]"/ge;
+    print $out $_;
+}
+close $out;
+open $in, '<', $species or die $!;
+open $out, '>', "$dir/species.txt" or die $!;
+while (<$in>) {
+    s/(\w)/species__$1/g;
+    print $out $_;
+}
+close $out;
+
+my @report = ('-b', '-C', '-k', 0);
+my $expected = urec('-S', $species, '-G', data_file('genes.txt'), @report);
+isnt($expected, '', "reference run");
+# species trees are shown with their leaves as written
+(my $got = urec('-m', "$dir/map1", '-m', "$dir/map2", '-S', "$dir/species.txt", '-G', "$dir/genes.txt", @report))
+    =~ s/species__//g;
+is($got, $expected, "gene and species trees in other spellings");
+
+my ($stdout, $err, $status) = run($urec, '-S', "$dir/species.txt", '-G', "$dir/genes.txt", @report,
+                                  '-m', "$dir/map1", '-m', "$dir/map2");
+ok($status && $err =~ /not found in the species tree/, "trees read before -m are not mapped");
+
+open $out, '>', "$dir/bad" or die $!;
+print $out "variety a => species_a\nvariety b\n";
+close $out;
+($stdout, $err, $status) = run($urec, '-m', "$dir/bad", '-S', $species, '-G', data_file('genes.txt'), '-b');
+ok($status && $err =~ /variant => standard expected/, "a map line without =>");
+
+done_testing();
@@ -0,0 +1,54 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+
+use UrecTest;
+
+# -N num,seed: the cost of every pair against num random trees over the
+# same leaves; a seed gives the same random trees on any number of threads
+plan skip_all => "no urec with -N built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-N');
+
+my $urec = urec_tool('urec');
+my $species = data_file('species.txt');
+my $num = 200;
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes));
+    my ($out, $err, $status) = run($urec, @args, '-N', "$num,7", '-j', 1);
+    is($status, 0, "$genes -N $num,7");
+    like($err, qr/^Null model seed: 7$/m, "$genes: the seed on stderr");
+    is((run($urec, @args, '-N', "$num,7", '-j', 3))[0], $out, "$genes: the same on 3 threads");
+    isnt((run($urec, @args, '-N', "$num,8"))[0], $out, "$genes: another seed, other trees");
+
+    # without a seed it is shown, and gives the run again
+    my ($again, $seederr) = run($urec, @args, '-N', $num);
+    my ($seed) = $seederr =~ /^Null model seed: (\d+)$/m;
+    ok(defined $seed, "$genes: a seed of its own");
+    is((run($urec, @args, '-N', "$num,$seed"))[0], $again, "$genes: which repeats the run") if defined $seed;
+
+    # species, gene, cost, p-value, mean, variance
+    my @o = map { /^\((\d+),(\d+)\)/ && $1 + $2 } split /\n/, urec(@args, '-b', '-o');
+    my @rows = map { [split /\t/] } split /\n/, $out;
+    is(scalar @rows, scalar @o, "$genes: a row per pair");
+    my ($ok, $i) = (1, 0);
+    foreach my $r (@rows) {
+        my ($s, $g, $cost, $p, $mean, $var) = @$r;
+        my $k = $p * ($num + 1);
+        $ok = 0, diag("@$r") unless $cost == $o[$i++] && $p > 0 && $p <= 1 && abs($k - int($k + 0.5)) < 1e-3
+            && $mean >= 0 && $var >= 0;
+    }
+    ok($ok, "$genes: the costs of -o, p-values in steps of 1/(num+1)");
+}
+
+# the species tree itself as a gene tree: hardly a random tree is as cheap
+my ($s0) = do { open my $fh, '<', $species or die $!; <$fh> };
+chomp $s0;
+my ($row) = split /\n/, urec('-s', $s0, '-g', $s0, '-N', "$num,7");
+my (undef, undef, $cost, $p) = split /\t/, $row;
+is($cost, 0, "a gene tree that is the species tree costs nothing");
+ok($p <= 5 / ($num + 1), "and has a small p-value ($p)");
+
+done_testing();
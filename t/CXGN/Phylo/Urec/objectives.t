@@ -0,0 +1,67 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+
+use UrecTest;
+
+# -W reports the optimum under every weight vector from one traversal; each
+# must be an optimum of a run with those weights alone (polytomies are
+# resolved with the weights of -D and -L, so those are given too)
+plan skip_all => "no urec with -W built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-W');
+
+my $species = data_file('species.txt');
+my @vectors = ([1, 1, 0], [2, 1, 0], [1, 3, 0], [1, 1, 1], [0, 0, 1]);
+my $w = join(':', map { join(',', @$_) } @vectors);
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+
+    # -F tsv: species, gene, weights, u, v, dup, loss
+    my %records;
+    foreach (split /\n/, urec(@args, '-F', 'tsv', '-W', $w)) {
+        my ($s, $g, $i, $u, $v, $dup, $loss) = split /\t/;
+        $records{$i}{"$s\t$g"} = [$v, $dup, $loss];
+    }
+    is(scalar(keys %records), scalar @vectors, "$genes -F tsv has every weight vector");
+
+    # -C: (dup,loss,deep coalescence) for every vector
+    my @totals = map { [map { [split /,/] } /\(([\d,]+)\)/g] } split /\n/, urec(@args, '-C', '-W', $w);
+    my @costs = map { [(split /\t/)[1 .. @vectors]] } split /\n/, urec(@args, '-c', '-W', $w);
+    is(scalar @totals, 3, "$genes -C for all species trees");
+    foreach my $s (0 .. $#totals) {
+        foreach my $i (0 .. $#vectors) {
+            my $t = $totals[$s][$i];
+            my $v = $vectors[$i];
+            is($costs[$s][$i], $v->[0] * $t->[0] + $v->[1] * $t->[1] + $v->[2] * $t->[2],
+               "$genes -c of species tree $s under @$v");
+        }
+    }
+
+    foreach my $i (0 .. $#vectors) {
+        my ($d, $l, $c) = @{$vectors[$i]};
+        next if $c;
+        my %r;
+        foreach (split /\n/, urec(@args, '-F', 'tsv', '-W', $w, '-D', $d, '-L', $l)) {
+            my ($s, $g, $j, $u, $v, $dup, $loss) = split /\t/;
+            $r{"$s\t$g"} = [$v, $dup, $loss] if $j == $i;
+        }
+        is_deeply(\%r, $records{$i}, "$genes -W $d,$l does not depend on -D and -L")
+            unless $genes =~ /poly/;
+        # the cheapest rootings with these weights alone, by gene tree
+        my @k = split /\n/, urec(@args, '-k', 0, '-D', $d, '-L', $l);
+        my ($ok, $n) = (1, 0);
+        foreach (split /\n/, urec(@args, '-F', 'tsv', '-D', $d, '-L', $l)) {
+            my ($s, $g, undef, $u, $v, $dup, $loss) = split /\t/;
+            my $r = $r{"$s\t$g"};
+            my $best = $k[$n++];
+            $ok = 0, diag("species $s gene $g: @{$r || []}, not one of $best")
+                unless $r && $r->[1] == $dup && $r->[2] == $loss && $best =~ /(^| )$r->[0]\($dup,$loss\)/;
+        }
+        ok($ok && $n == keys %r, "$genes -W rootings are optimal under -D $d -L $l");
+    }
+}
+
+done_testing();
@@ -0,0 +1,88 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -t leaves out the gene leaves whose species are not in the species tree:
+# the costs are those of the gene trees without them
+plan skip_all => "no urec with -t built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-t');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+
+# a newick tree as nested arrays of leaf labels
+sub parse {
+    my ($newick) = @_;
+    my @stack = ([]);
+    my $last = '';
+    foreach my $t ($newick =~ /([(),;]|[^(),;\s]+)/g) {
+        if ($t eq '(') { push @stack, [] }
+        elsif ($t eq ')') { my $n = pop @stack; push @{$stack[-1]}, $n }
+        elsif ($t ne ',' && $t ne ';' && $last ne ')') { push @{$stack[-1]}, $t }
+        $last = $t;
+    }
+    return $stack[0][0];
+}
+
+# without the leaves that match, and without nodes of one child
+sub prune {
+    my ($n, $drop) = @_;
+    return $n =~ $drop ? undef : $n unless ref $n;
+    my @c = grep { defined } map { prune($_, $drop) } @$n;
+    return @c == 0 ? undef : @c == 1 ? $c[0] : \@c;
+}
+
+sub newick {
+    my ($n) = @_;
+    return ref $n ? '(' . join(',', map { newick($_) } @$n) . ')' : $n;
+}
+
+# the species trees without h
+open my $in, '<', data_file('species.txt') or die $!;
+open my $out, '>', "$dir/species.txt" or die $!;
+print $out newick(prune(parse($_), qr/^h$/)), ";\n" while <$in>;
+close $out;
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    open $in, '<', data_file($genes) or die $!;
+    my @trees = <$in>;
+    my $h = 0;
+    $h += () = /\[species=h\]|(?<=[(,])h(?=[),])/g foreach @trees;
+    my $drop = qr/\[species=h\]|^h$/;
+    open $out, '>', "$dir/$genes" or die $!;
+    print $out newick(prune(parse($_), $drop)), ";\n" foreach @trees;
+    close $out;
+
+    foreach my $opts (['-c', '-C'], ['-d'], ['-o']) {
+        my $expected = urec('-S', "$dir/species.txt", '-G', "$dir/$genes", '-b', @$opts);
+        my ($got, $err, $status) = run($urec, '-t', '-S', "$dir/species.txt", '-G', data_file($genes), '-b', @$opts);
+        is($status, 0, "$genes -t @$opts");
+        is($got, $expected, "$genes -t @$opts: the costs without the leaves of h");
+        like($err, qr/^${\(3 * $h)} gene leaves not in the species tree taken out/m, "$genes -t @$opts: the leaves counted");
+    }
+
+    # the events of the pruned trees
+    my ($v, $err, $status) = run($urec, '-t', '-S', "$dir/species.txt", '-G', data_file($genes), '-b', '-V');
+    is($status, 0, "$genes -t -V");
+    my (%dups, %f);
+    foreach (split /\n/, $v) {
+        my @r = split /\t/;
+        $dups{"$r[0] $r[1]"} += $r[5];
+    }
+    foreach (split /\n/, urec('-t', '-S', "$dir/species.txt", '-G', data_file($genes), '-b', '-F', 'tsv')) {
+        my @r = split /\t/;
+        $f{"$r[0] $r[1]"} = $r[5];
+    }
+    is_deeply(\%dups, \%f, "$genes -t -V: the duplications of -t -F tsv");
+
+    # without -t the leaves of h are an error
+    (undef, $err, $status) = run($urec, '-S', "$dir/species.txt", '-G', data_file($genes), '-b', '-c');
+    ok($status && $err =~ /not found in the species tree/, "$genes: without -t an error");
+}
+
+done_testing();
@@ -0,0 +1,67 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use JSON::PP;
+
+use UrecTest;
+
+# -F tsv and -F json: a record per pair with the optimal edge as the
+# preorder indices of its ends in the input tree
+plan skip_all => "no urec with -F built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-F');
+
+my $species = data_file('species.txt');
+my @fields = qw/species gene weights u v dup loss/;
+
+# the parent of every node of a newick tree, in preorder
+sub parents {
+    my ($newick) = @_;
+    my (@parent, @stack);
+    my $last;
+    foreach my $t ($newick =~ /([(),;]|[^(),;\s]+)/g) {
+        if ($t eq '(') {
+            push @parent, @stack ? $stack[-1] : -1;
+            push @stack, $#parent;
+        }
+        elsif ($t eq ')') {
+            pop @stack;
+        }
+        elsif ($t ne ',' && $t ne ';' && $last ne ')') {
+            push @parent, $stack[-1];
+        }
+        $last = $t;
+    }
+    return \@parent;
+}
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    open my $fh, '<', data_file($genes) or die $!;
+    my @parents = map { parents($_) } <$fh>;
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    my @tsv = map { [split /\t/] } split /\n/, urec(@args, '-F', 'tsv');
+    my @json = map { decode_json($_) } split /\n/, urec(@args, '-F', 'json');
+    my @o = map { [/^\((\d+),(\d+)\)/] } split /\n/, urec(@args, '-o');
+    is(scalar @tsv, 3 * @parents, "$genes: a tsv record per pair");
+    is_deeply([map { [@$_{@fields}] } @json], \@tsv, "$genes: json records are the tsv ones");
+
+    my ($order, $costs, $edges) = (1, 1, 1);
+    foreach my $i (0 .. $#tsv) {
+        my ($s, $g, $w, $u, $v, $dup, $loss) = @{$tsv[$i]};
+        $order = 0 unless $s == int($i / @parents) && $g == $i % @parents && $w == 0;
+        $costs = 0 unless $dup == $o[$i][0] && $loss == $o[$i][1];
+        # v is below u; a root of two children is no node, its edge joins
+        # them; inside a polytomy the edge can be a new one, both ends in
+        # the polytomy's node
+        my $p = $parents[$g];
+        my @top = grep { $p->[$_] == 0 } 1 .. $#$p;
+        my $up = @top == 2 && $p->[$v] == 0 ? ($v == $top[0] ? $top[1] : $top[0]) : $p->[$v];
+        $edges = 0 unless $v > 0 && $v < @$p && ($up == $u || $genes =~ /poly/ && $u == $v);
+    }
+    ok($order, "$genes: species, gene and weights count the pairs in order");
+    ok($costs, "$genes: the costs of -o");
+    ok($edges, "$genes: u and v are the ends of an edge");
+}
+
+done_testing();
@@ -0,0 +1,54 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -J i/N runs the i-th of N runs of consecutive gene trees; the records of
+# all shards are those of one run, and urec-merge adds up their summaries
+plan skip_all => "no urec with -J and urec-merge built in lib/CXGN/Phylo/Urec (or \$UREC)"
+    unless urec_has('-J') && -x urec_tool('urec-merge');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+my $merge = urec_tool('urec-merge');
+my $species = data_file('species.txt');
+
+# records by species tree, then gene tree
+sub bypair {
+    return join('', sort { my @a = split /\t/, $a; my @b = split /\t/, $b; $a[0] <=> $b[0] || $a[1] <=> $b[1] } @_);
+}
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    my $records = urec(@args, '-F', 'tsv');
+    foreach my $summary (['-c', '-C', '-d'], ['-x'], ['-v']) {
+        my $expected = urec(@args, @$summary);
+        foreach my $n (1, 3, 7) {
+            my (@files, @lines);
+            foreach my $i (0 .. $n - 1) {
+                my ($out, $err, $status) = run($urec, @args, @$summary, '-F', 'tsv', '-J', "$i/$n,$dir/shard$i");
+                is($status, 0, "$genes @$summary: shard $i of $n") or diag($err);
+                push @files, "$dir/shard$i";
+                push @lines, $out =~ /^(.*\n)/mg;
+            }
+            is(bypair(@lines), bypair($records =~ /^(.*\n)/mg), "$genes @$summary: the records of $n shards");
+            is((run($merge, reverse @files))[0], $expected, "$genes @$summary: urec-merge of $n shards");
+        }
+    }
+}
+
+# all the shards, each once
+run($urec, '-S', $species, '-G', data_file('genes.txt'), '-b', '-c', '-J', "$_/3,$dir/s$_") foreach (0 .. 2);
+my (undef, $err, $status) = run($merge, "$dir/s0", "$dir/s1");
+ok($status && $err =~ /one of 3 shards, 2 given/, "urec-merge wants every shard");
+(undef, $err, $status) = run($merge, "$dir/s0", "$dir/s1", "$dir/s1");
+ok($status && $err =~ /Shard 1 given twice/, "urec-merge wants every shard once");
+(undef, $err, $status) = run($urec, '-S', $species, '-G', data_file('genes.txt'), '-b', '-c', '-J', "3/3,$dir/s3");
+ok($status, "-J rejects a shard out of range");
+
+done_testing();
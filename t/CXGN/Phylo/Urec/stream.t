@@ -0,0 +1,70 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+use IO::Compress::Gzip qw/gzip $GzipError/;
+use IPC::Open3;
+use File::Spec;
+
+use UrecTest;
+
+# -y streams species trees a block at a time against the gene trees; it
+# shows what -S with -b shows, and from a pipe answers every tree as soon
+# as its line is in
+plan skip_all => "no urec with -y built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-y');
+
+my $dir = tempdir(CLEANUP => 1);
+my $urec = urec_tool('urec');
+
+# more species trees than a block
+my $species = "$dir/species.txt";
+open my $out, '>', $species or die $!;
+print $out urec('-l', 300, '-E', 8, '-u', '-r', 'abcdefgh', '-p');
+close $out;
+gzip($species => "$species.gz") or die $GzipError;
+my $trees = do { open my $fh, '<', $species or die $!; local $/; <$fh> };
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @g = ('-G', data_file($genes));
+    foreach my $opts (['-o'], ['-F', 'tsv'], ['-c', '-C'], ['-c', '-C', '-F', 'json']) {
+        my $expected = urec('-S', $species, @g, '-b', @$opts);
+        ok(urec('-y', $species, @g, @$opts) eq $expected, "$genes -y @$opts");
+        ok(urec('-y', "$species.gz", @g, @$opts) eq $expected, "$genes -y @$opts, gzip");
+        ok(urec('-y', '-', @g, @$opts, \$trees) eq $expected, "$genes -y @$opts from standard input");
+        ok(urec('-I', '-y', $species, @g, @$opts) eq $expected, "$genes -I -y @$opts");
+    }
+}
+
+# one tree at a time through a pipe
+my $genes = data_file('genes.txt');
+my $n = () = do { open my $fh, '<', $genes or die $!; <$fh> };
+my ($from, $to);
+open my $null, '>', File::Spec->devnull() or die $!;
+my $pid = open3($to, $from, '>&' . fileno($null), $urec, '-y', '-', '-G', $genes, '-F', 'tsv');
+my @lines = split /\n/, $trees;
+my $ok = 1;
+eval {
+    local $SIG{ALRM} = sub { die "timeout\n" };
+    foreach my $i (0 .. 4) {
+        alarm 30;
+        print $to "$lines[$i]\n";
+        $to->flush();
+        my $got = '';
+        $got .= <$from> foreach 1 .. $n;
+        alarm 0;
+        my $expected = urec('-s', $lines[$i], '-G', $genes, '-b', '-F', 'tsv');
+        $expected =~ s/^0\t/$i\t/mg;
+        $ok = 0 unless $got eq $expected;
+    }
+};
+alarm 0;
+close $to;
+kill 'KILL', $pid if $@;
+waitpid($pid, 0);
+is($@, '', "answers before the pipe is closed");
+ok($ok, "the answers of one species tree at a time");
+
+done_testing();
@@ -0,0 +1,45 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use File::Temp qw/tempdir/;
+
+use UrecTest;
+
+# -b with only -o, -c, -C, -F or -v evaluates the pairs tile by tile on all
+# threads; that must give what the pair by pair loop gives, with any number
+# of threads
+plan skip_all => "no urec with -j and -Z built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-j', '-Z');
+
+my $dir = tempdir(CLEANUP => 1);
+
+# random species trees and many gene trees, for several tiles each way
+my $species = "$dir/species.txt";
+open my $out, '>', $species or die $!;
+print $out urec('-l', 30, '-E', 8, '-u', '-r', 'abcdefgh', '-p');
+close $out;
+foreach my $genes ('genes.txt', 'poly.txt') {
+    open my $in, '<', data_file($genes) or die $!;
+    my $trees = do { local $/; <$in> };
+    open $out, '>', "$dir/$genes" or die $!;
+    print $out $trees x 20;
+    close $out;
+}
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', "$dir/$genes", '-b');
+    my @report = ('-F', 'tsv', '-c', '-C');
+    # -Z needs the gene tree of every pair, so it goes pair by pair
+    my $expected = urec(@args, @report, '-Z', "$dir/dist.bin", '-j', 1);
+    my $trees = () = urec('-G', "$dir/$genes", '-p') =~ /\n/g;
+    is(scalar(() = $expected =~ /\n/g), 30 * ($trees + 1), "$genes: a record per pair and totals per species tree");
+    my $votes = urec(@args, '-v', '-j', 1);
+    foreach my $threads (1, 2, 5) {
+        ok(urec(@args, @report, '-j', $threads) eq $expected, "$genes: tiles on $threads threads");
+        is(urec(@args, '-v', '-j', $threads), $votes, "$genes: -v on $threads threads");
+    }
+}
+
+done_testing();
@@ -0,0 +1,63 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+
+use UrecTest;
+
+# -k num lists the num cheapest rootings, edge(dup,loss) by cost and then
+# edge; -k 0 all the optimal ones
+plan skip_all => "no urec with -k built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-k');
+
+my $species = data_file('species.txt');
+
+# [[edge, dup, loss], ...] of every line
+sub rootings {
+    return map { [map { [/^(\d+)\((\d+),(\d+)\)$/] } split / /] } split /\n/, $_[0];
+}
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    open my $fh, '<', data_file($genes) or die $!;
+    my $trees = () = <$fh>;
+    foreach my $w ([1, 1], [2, 1], [1, 3]) {
+        my ($d, $l) = @$w;
+        my @args = ('-S', $species, '-G', data_file($genes), '-b', '-D', $d, '-L', $l);
+        my $cost = sub { $d * $_[0][1] + $l * $_[0][2] };
+        my @all = rootings(urec(@args, '-k', 100000));
+        my @opt = rootings(urec(@args, '-k', 0));
+        my @three = rootings(urec(@args, '-k', 3));
+        my @o = map { [0, /^\((\d+),(\d+)\)/] } split /\n/, urec(@args, '-o');
+        my @f = map { [(split /\t/)[4]] } split /\n/, urec(@args, '-F', 'tsv');
+        is(scalar @all, 3 * $trees, "$genes -D $d -L $l: a line per pair");
+        is(scalar @opt, scalar @all, "$genes -D $d -L $l: -k 0 a line per pair");
+
+        my ($sorted, $optimal, $prefix, $found, $edges) = (1, 1, 1, 1, 1);
+        foreach my $i (0 .. $#all) {
+            my $r = $all[$i];
+            foreach my $j (1 .. $#$r) {
+                my ($a, $b) = ($r->[$j - 1], $r->[$j]);
+                $sorted = 0 unless $cost->($a) < $cost->($b) or $cost->($a) == $cost->($b) && $a->[0] <= $b->[0];
+            }
+            # all the rootings with the cost of -o, and only those
+            my @best = grep { $cost->($_) == $cost->($o[$i]) } @$r;
+            $optimal = 0 unless @best && "@{[map { qq/@$_/ } @best]}" eq "@{[map { qq/@$_/ } @{$opt[$i]}]}"
+                && $cost->($r->[0]) == $cost->($o[$i]);
+            $prefix = 0 unless "@{[map { qq/@$_/ } @{$three[$i]}]}" eq "@{[map { qq/@$_/ } @$r[0 .. 2]]}";
+            $found = 0 unless grep { $_->[0] == $f[$i][0] } @best;
+            # of a binary tree every edge once: 1 .. 2n-3
+            if ($genes eq 'genes.txt') {
+                my @e = sort { $a <=> $b } map { $_->[0] } @$r;
+                $edges = 0 unless "@e" eq join(' ', 1 .. scalar @e) && @e % 2;
+            }
+        }
+        ok($sorted, "$genes -D $d -L $l: sorted by cost, then edge");
+        ok($optimal, "$genes -D $d -L $l: -k 0 gives the rootings of the cost of -o");
+        ok($prefix, "$genes -D $d -L $l: -k 3 gives the first three");
+        ok($found, "$genes -D $d -L $l: the edge of -F is one of -k 0");
+        ok($edges, "$genes -D $d -L $l: every edge") if $genes eq 'genes.txt';
+    }
+}
+
+done_testing();
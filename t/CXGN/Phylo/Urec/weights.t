@@ -0,0 +1,44 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+
+use UrecTest;
+
+# integral -D and -L are summed and compared in integer arithmetic, others
+# in doubles; both must choose the same rootings for proportional weights
+plan skip_all => "no urec with -D built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-D', '-L');
+
+my $species = data_file('species.txt');
+
+# species tree => [dup, loss] of -C
+sub totals {
+    my %t;
+    foreach (split /\n/, $_[0]) {
+        my ($s, $dup, $loss) = /^(\S+)\t\((\d+),(\d+)\)/ or die "unexpected -C output: $_";
+        $t{$s} = [$dup, $loss];
+    }
+    return \%t;
+}
+
+foreach my $genes ('genes.txt', 'poly.txt') {
+    my @args = ('-S', $species, '-G', data_file($genes), '-b');
+    foreach my $w ([2, 3], [1000003, 1000033]) {
+        my ($d, $l) = @$w;
+        my $totals = totals(urec(@args, '-C', '-D', $d, '-L', $l));
+        my $costs = urec(@args, '-c', '-D', $d, '-L', $l);
+        is(scalar(keys %$totals), 3, "$genes -C with -D $d -L $l");
+        foreach (split /\n/, $costs) {
+            my ($s, $c) = split /\t/;
+            is($c, $d * $totals->{$s}[0] + $l * $totals->{$s}[1], "$genes exact -c of $s with -D $d -L $l");
+        }
+    }
+    foreach my $opts (['-F', 'tsv'], ['-C'], ['-k', 0]) {
+        is(urec(@args, @$opts, '-D', 1.5, '-L', 1), urec(@args, @$opts, '-D', 3, '-L', 2),
+           "$genes @$opts with -D 1.5 -L 1 and -D 3 -L 2");
+    }
+}
+
+done_testing();
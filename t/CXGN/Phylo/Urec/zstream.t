@@ -0,0 +1,79 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+use FindBin;
+use lib $FindBin::RealBin;
+use POSIX qw/mkfifo/;
+use File::Temp qw/tempdir/;
+use IO::Compress::Gzip qw/gzip $GzipError/;
+use IO::Uncompress::Gunzip qw/gunzip $GunzipError/;
+
+use UrecTest;
+
+# -G and -S read from pipes and compressed files, -w writes compressed
+plan skip_all => "no urec with -w built in lib/CXGN/Phylo/Urec (or \$UREC)" unless urec_has('-w');
+
+my $dir = tempdir(CLEANUP => 1);
+my $species = data_file('species.txt');
+my $genes = data_file('genes.txt');
+my @report = ('-b', '-c', '-F', 'tsv');
+my $expected = urec('-S', $species, '-G', $genes, @report);
+like($expected, qr/^0\t0\t0\t/, "reference run");
+
+sub slurp {
+    my ($fn) = @_;
+    open my $fh, '<', $fn or die "$fn: $!";
+    local $/;
+    return <$fh>;
+}
+
+# a FIFO that a child fills with $data once it is opened
+my @writers;
+sub fifo {
+    my ($name, $data) = @_;
+    my $path = "$dir/$name";
+    mkfifo($path, 0600) or die "mkfifo $path: $!";
+    my $pid = fork();
+    die "fork: $!" unless defined $pid;
+    if (!$pid) {
+        open my $w, '>', $path or POSIX::_exit(1);
+        print $w $data;
+        close $w;
+        POSIX::_exit(0);
+    }
+    push @writers, $pid;
+    return $path;
+}
+
+sub reap {
+    kill 'TERM', @writers;
+    waitpid($_, 0) foreach @writers;
+    @writers = ();
+}
+
+is(urec('-S', fifo('sp', slurp($species)), '-G', fifo('g', slurp($genes)), @report), $expected,
+   "-S and -G through pipes");
+reap();
+
+is(urec('-S', $species, '-G', '-', @report, \slurp($genes)), $expected, "-G from standard input");
+is(urec('-S', '-', '-G', $genes, @report, \slurp($species)), $expected, "-S from standard input");
+
+gzip($genes => "$dir/genes.gz") or die $GzipError;
+gzip($species => "$dir/species.gz") or die $GzipError;
+is(urec('-S', "$dir/species.gz", '-G', "$dir/genes.gz", @report), $expected, "gzip compressed -S and -G");
+is(urec('-S', fifo('spz', slurp("$dir/species.gz")), '-G', fifo('gz', slurp("$dir/genes.gz")), @report), $expected,
+   "gzip compressed -S and -G through pipes");
+reap();
+
+# the binary format of -T, from a file and through a pipe
+urec('-T', "$dir/genes.bin", '-G', $genes);
+is(urec('-S', $species, '-G', fifo('gbin', slurp("$dir/genes.bin")), @report), $expected,
+   "binary -G through a pipe");
+reap();
+
+urec('-S', $species, '-G', $genes, @report, '-w', "$dir/out.gz");
+gunzip("$dir/out.gz" => \my $out) or die $GunzipError;
+is($out, $expected, "-w writes gzip");
+
+done_testing();
@@ -0,0 +1,55 @@
+#!/usr/bin/perl
+use strict;
+use warnings;
+use Test::More;
+
+use CXGN::Phylo::Tree;
+use CXGN::Phylo::Parser;
+
+# find_mindl_node runs urec; use the one built in lib/CXGN/Phylo/Urec (or
+# $ENV{UREC}), skip if there is none that knows -F tsv
+my $urec = eval { CXGN::Phylo::Tree::urec_command() };
+plan skip_all => "no usable urec: $@" unless(defined $urec);
+
+my $species_tree = CXGN::Phylo::Parse_newick->new("((tomato:1, potato:1):1, (pepper:1, coffee:1):1)")->parse();
+foreach my $leaf ($species_tree->get_root()->recursive_leaf_list()) {
+	$leaf->set_species($leaf->get_name());
+}
+
+# rooted next to d1; the optimal root separates a1,b1 from c1,d1
+my %species = (a1 => "tomato", b1 => "potato", c1 => "pepper", d1 => "coffee");
+my $gene_tree = CXGN::Phylo::Parse_newick->new("(((a1:1, b1:1):1, c1:1):1, d1:1)")->parse();
+foreach my $leaf ($gene_tree->get_root()->recursive_leaf_list()) {
+	$leaf->set_species($species{$leaf->get_name()});
+}
+
+my ($node, $distance) = CXGN::Phylo::Tree::find_mindl_node($gene_tree, $species_tree);
+ok(defined $node, "find_mindl_node finds a node");
+is(join(",", sort map { $_->get_name() } $node->recursive_leaf_list()), "a1,b1", "find_mindl_node root separates a1,b1 from c1,d1");
+is($distance, 0.5, "find_mindl_node reroots half way along the branch");
+
+# a polytomy is passed to urec as it is
+my $poly_tree = CXGN::Phylo::Parse_newick->new("((a1:1, b1:1, c1:1):1, d1:1)")->parse();
+foreach my $leaf ($poly_tree->get_root()->recursive_leaf_list()) {
+	$leaf->set_species($species{$leaf->get_name()});
+}
+my $points = CXGN::Phylo::Tree::find_mindl_nodes([$gene_tree, $poly_tree], $species_tree);
+is(scalar @$points, 2, "find_mindl_nodes gives a point for every gene tree");
+# the optimal root, between a1,b1 and c1,d1, is inside the polytomy
+is($points->[1][0], ($poly_tree->get_root()->get_children())[0], "find_mindl_nodes gives the polytomy");
+is($points->[1][1], 0, "find_mindl_nodes gives the polytomy itself");
+
+# -I keeps quoted species names with blanks as they were parsed
+my $quoted_species = "(('Homo sapiens','Pan troglodytes'),('Mus musculus',Rattus));";
+my $quoted_gene = "((g1[species=Homo sapiens],g2[species=Mus musculus]),(g3[species=Pan troglodytes],g4[species=Rattus]));";
+my $full = `$urec -s "$quoted_species" -g "$quoted_gene" -b -F tsv 2>&1`;
+my $induced = `$urec -I -s "$quoted_species" -g "$quoted_gene" -b -F tsv 2>&1`;
+is($full, "0\t0\t0\t4\t1\t1\t4\n", "urec with quoted species names");
+is($induced, $full, "urec -I with quoted species names");
+
+# malformed trees are parse errors
+foreach my $gene ("(g1,,g2);", "((g1,g2)g3);", "((g1,g2),g3); g4") {
+	like(`$urec -s "((g1,g2),g3);" -g "$gene" -b 2>&1`, qr/^Parse error/, "urec rejects $gene");
+}
+
+done_testing();